@@ -0,0 +1,103 @@
+#include "AsyncCompute.hpp"
+
+namespace ezvk {
+OwnershipTransfer& OwnershipTransfer::addBuffer(
+    VkBuffer buffer, VkPipelineStageFlags2 srcStage, VkAccessFlags2 srcAccess,
+    VkPipelineStageFlags2 dstStage, VkAccessFlags2 dstAccess,
+    VkDeviceSize offset, VkDeviceSize size) {
+  buffers.push_back({
+      .sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+      .pNext               = nullptr,
+      .srcStageMask        = srcStage,
+      .srcAccessMask       = srcAccess,
+      .dstStageMask        = dstStage,
+      .dstAccessMask       = dstAccess,
+      .srcQueueFamilyIndex = srcFamily,
+      .dstQueueFamilyIndex = dstFamily,
+      .buffer              = buffer,
+      .offset              = offset,
+      .size                = size,
+  });
+  return *this;
+}
+
+OwnershipTransfer& OwnershipTransfer::addImage(
+    VkImage image, VkImageSubresourceRange range, VkImageLayout oldLayout,
+    VkImageLayout newLayout, VkPipelineStageFlags2 srcStage,
+    VkAccessFlags2 srcAccess, VkPipelineStageFlags2 dstStage,
+    VkAccessFlags2 dstAccess) {
+  images.push_back({
+      .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+      .pNext               = nullptr,
+      .srcStageMask        = srcStage,
+      .srcAccessMask       = srcAccess,
+      .dstStageMask        = dstStage,
+      .dstAccessMask       = dstAccess,
+      .oldLayout           = oldLayout,
+      .newLayout           = newLayout,
+      .srcQueueFamilyIndex = srcFamily,
+      .dstQueueFamilyIndex = dstFamily,
+      .image               = image,
+      .subresourceRange    = range,
+  });
+  return *this;
+}
+
+void OwnershipTransfer::recordRelease(Synchronization2 const& ext,
+                                      CommandBuffer&          cmd) const {
+  if (!familiesDiffer()) {
+    return;
+  }
+  // the destination half of a release is ignored
+  auto bufferBarriers = buffers;
+  for (auto& barrier : bufferBarriers) {
+    barrier.dstStageMask  = VK_PIPELINE_STAGE_2_NONE;
+    barrier.dstAccessMask = VK_ACCESS_2_NONE;
+  }
+  auto imageBarriers = images;
+  for (auto& barrier : imageBarriers) {
+    barrier.dstStageMask  = VK_PIPELINE_STAGE_2_NONE;
+    barrier.dstAccessMask = VK_ACCESS_2_NONE;
+  }
+  cmd.pipelineBarrier2(ext, u32(bufferBarriers.size()), bufferBarriers.data(),
+                       u32(imageBarriers.size()), imageBarriers.data());
+}
+
+// The source half chains onto the semaphore wait, which should use the
+// consumer stage as its wait stage.
+void OwnershipTransfer::recordAcquire(Synchronization2 const& ext,
+                                      CommandBuffer&          cmd) const {
+  u32 family = familiesDiffer() ? srcFamily : VK_QUEUE_FAMILY_IGNORED;
+
+  auto bufferBarriers = buffers;
+  for (auto& barrier : bufferBarriers) {
+    barrier.srcStageMask        = barrier.dstStageMask;
+    barrier.srcAccessMask       = VK_ACCESS_2_NONE;
+    barrier.srcQueueFamilyIndex = family;
+    barrier.dstQueueFamilyIndex = familiesDiffer() ? dstFamily : family;
+  }
+  auto imageBarriers = images;
+  for (auto& barrier : imageBarriers) {
+    barrier.srcStageMask        = barrier.dstStageMask;
+    barrier.srcAccessMask       = VK_ACCESS_2_NONE;
+    barrier.srcQueueFamilyIndex = family;
+    barrier.dstQueueFamilyIndex = familiesDiffer() ? dstFamily : family;
+  }
+  cmd.pipelineBarrier2(ext, u32(bufferBarriers.size()), bufferBarriers.data(),
+                       u32(imageBarriers.size()), imageBarriers.data());
+}
+
+u64 AsyncCompute::submit(VkCommandBuffer cmd, u64 graphicsValue,
+                         VkPipelineStageFlags2 waitStage) {
+  u64 value;
+  if (graphicsValue != 0) {
+    VkSemaphoreSubmitInfo wait = graphics->dependency(graphicsValue, waitStage);
+    value                      = compute->submit(cmd, {&wait, 1});
+  } else {
+    value = compute->submit(cmd);
+  }
+  auto result = compute->flush();
+  assert(result == VK_SUCCESS);
+  return value;
+}
+} // namespace ezvk
@@ -0,0 +1,78 @@
+#pragma once
+#include "common.hpp"
+
+#include "Command.hpp"
+#include "Queue.hpp"
+
+namespace ezvk {
+// Queue-family ownership transfer of VK_SHARING_MODE_EXCLUSIVE resources.
+// The release half is recorded on the source queue, the acquire half on the
+// destination queue, and the two submits must be ordered by a semaphore.
+// With equal families no ownership moves and only the acquire side records
+// a barrier, for the layout transitions.
+struct OwnershipTransfer {
+  u32 srcFamily;
+  u32 dstFamily;
+
+  std::vector<VkBufferMemoryBarrier2> buffers;
+  std::vector<VkImageMemoryBarrier2>  images;
+
+  OwnershipTransfer& addBuffer(VkBuffer buffer, VkPipelineStageFlags2 srcStage,
+                               VkAccessFlags2        srcAccess,
+                               VkPipelineStageFlags2 dstStage,
+                               VkAccessFlags2        dstAccess,
+                               VkDeviceSize          offset = 0,
+                               VkDeviceSize          size   = VK_WHOLE_SIZE);
+  OwnershipTransfer& addImage(VkImage image, VkImageSubresourceRange range,
+                              VkImageLayout oldLayout, VkImageLayout newLayout,
+                              VkPipelineStageFlags2 srcStage,
+                              VkAccessFlags2        srcAccess,
+                              VkPipelineStageFlags2 dstStage,
+                              VkAccessFlags2        dstAccess);
+
+  bool familiesDiffer() const {
+    return srcFamily != dstFamily;
+  }
+  void recordRelease(Synchronization2 const& ext, CommandBuffer& cmd) const;
+  void recordAcquire(Synchronization2 const& ext, CommandBuffer& cmd) const;
+};
+
+// Runs work on the dedicated compute queue next to the graphics queue.
+//
+//   auto toCompute = async.toCompute().addBuffer(particles, ...);
+//   toCompute.recordRelease(graphics.sync2(), graphicsCmd);
+//   u64 g = graphics.submit(graphicsCmd);
+//   toCompute.recordAcquire(compute.sync2(), computeCmd);  // ... dispatches
+//   u64 c = async.submit(computeCmd, g,
+//                        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT);
+//   VkSemaphoreSubmitInfo waits[]{async.graphicsWait(c, stage)};
+//   graphics.submit(nextCmd, waits);
+class AsyncCompute {
+public:
+  Queue* graphics;
+  Queue* compute;
+
+  void create(Queue* graphics, Queue* compute) {
+    this->graphics = graphics;
+    this->compute  = compute;
+  }
+
+  OwnershipTransfer toCompute() const {
+    return {graphics->familyIndex, compute->familyIndex};
+  }
+  OwnershipTransfer toGraphics() const {
+    return {compute->familyIndex, graphics->familyIndex};
+  }
+
+  // Submits to the compute queue, waiting for `graphicsValue` on the
+  // graphics timeline first (0 for no wait), and flushes immediately so the
+  // work can overlap with rasterization. Returns the compute timeline value.
+  u64 submit(VkCommandBuffer cmd, u64 graphicsValue,
+             VkPipelineStageFlags2 waitStage);
+
+  VkSemaphoreSubmitInfo graphicsWait(u64                   computeValue,
+                                     VkPipelineStageFlags2 stage) {
+    return compute->dependency(computeValue, stage);
+  }
+};
+} // namespace ezvk
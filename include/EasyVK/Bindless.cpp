@@ -0,0 +1,201 @@
+#include "Bindless.hpp"
+
+namespace ezvk {
+/*
+  IndexFreeList
+ */
+
+void IndexFreeList::create(u32 capacity) {
+  m_capacity = capacity;
+  m_next     = std::make_unique<std::atomic<u32>[]>(capacity);
+  m_head.store(INVALID, std::memory_order_relaxed);
+  m_unused.store(0, std::memory_order_relaxed);
+}
+
+u32 IndexFreeList::acquire() {
+  u64 head = m_head.load(std::memory_order_acquire);
+  while (u32(head) != INVALID) {
+    u32 index = u32(head);
+    u32 next  = m_next[index].load(std::memory_order_relaxed);
+    u64 desired = ((head >> 32) + 1) << 32 | next;
+    if (m_head.compare_exchange_weak(head, desired, std::memory_order_acq_rel,
+                                     std::memory_order_acquire)) {
+      return index;
+    }
+  }
+
+  u32 unused = m_unused.load(std::memory_order_relaxed);
+  while (unused < m_capacity) {
+    if (m_unused.compare_exchange_weak(unused, unused + 1,
+                                       std::memory_order_relaxed)) {
+      return unused;
+    }
+  }
+  return INVALID;
+}
+
+void IndexFreeList::release(u32 index) {
+  assert(index < m_capacity);
+  u64 head = m_head.load(std::memory_order_relaxed);
+  u64 desired;
+  do {
+    m_next[index].store(u32(head), std::memory_order_relaxed);
+    desired = ((head >> 32) + 1) << 32 | index;
+  } while (!m_head.compare_exchange_weak(head, desired,
+                                         std::memory_order_release,
+                                         std::memory_order_relaxed));
+}
+
+/*
+  BindlessHeap
+ */
+
+static constexpr VkDescriptorType BINDING_TYPES[BindlessHeap::BindingCount]{
+    VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+    VK_DESCRIPTOR_TYPE_SAMPLER,
+    VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+};
+
+VkPhysicalDeviceVulkan12Features BindlessHeap::requiredFeatures() {
+  return {
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+      .pNext = nullptr,
+      .descriptorIndexing                            = VK_TRUE,
+      .shaderSampledImageArrayNonUniformIndexing     = VK_TRUE,
+      .shaderStorageBufferArrayNonUniformIndexing    = VK_TRUE,
+      .descriptorBindingSampledImageUpdateAfterBind  = VK_TRUE,
+      .descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE,
+      .descriptorBindingUpdateUnusedWhilePending     = VK_TRUE,
+      .descriptorBindingPartiallyBound               = VK_TRUE,
+      .runtimeDescriptorArray                        = VK_TRUE,
+  };
+}
+
+void BindlessHeap::create(VkPhysicalDevice gpu, VkDevice device,
+                          LayoutCache& layouts, Capacity capacity) {
+  VkPhysicalDeviceVulkan12Properties props12{
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES,
+      .pNext = nullptr,
+  };
+  VkPhysicalDeviceProperties2 props{
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+      .pNext = &props12,
+  };
+  vkGetPhysicalDeviceProperties2(gpu, &props);
+
+  u32 counts[BindingCount]{
+      std::min({capacity.textures,
+                props12.maxDescriptorSetUpdateAfterBindSampledImages,
+                props12.maxPerStageDescriptorUpdateAfterBindSampledImages}),
+      std::min({capacity.samplers,
+                props12.maxDescriptorSetUpdateAfterBindSamplers,
+                props12.maxPerStageDescriptorUpdateAfterBindSamplers}),
+      std::min({capacity.storageBuffers,
+                props12.maxDescriptorSetUpdateAfterBindStorageBuffers,
+                props12.maxPerStageDescriptorUpdateAfterBindStorageBuffers}),
+  };
+
+  constexpr VkDescriptorBindingFlags flags =
+      VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+      VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+      VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+
+  DescriptorSetLayoutBindingList        bindings;
+  std::vector<VkDescriptorBindingFlags> bindingFlags;
+  std::vector<VkDescriptorPoolSize>     poolSizes;
+  for (u32 i = 0; i < BindingCount; ++i) {
+    m_freeLists[i].create(counts[i]);
+    bindings.add(i, BINDING_TYPES[i], counts[i], VK_SHADER_STAGE_ALL);
+    bindingFlags.push_back(flags);
+    poolSizes.push_back({BINDING_TYPES[i], counts[i]});
+  }
+  m_setLayout = layouts.getSetLayout(
+      bindings, VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
+      bindingFlags);
+
+  auto result = m_pool.create(
+      device, VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT, 1, poolSizes);
+  assert(result == VK_SUCCESS);
+  m_set = m_pool.allocSet(device, *m_setLayout);
+}
+
+void BindlessHeap::destroy(VkDevice device) {
+  m_pool.destroy(device);
+  m_setLayout.reset();
+}
+
+void BindlessHeap::write(VkDevice device, Binding binding, u32 handle,
+                         const VkDescriptorImageInfo*  pImageInfo,
+                         const VkDescriptorBufferInfo* pBufferInfo) {
+  assert(handle < m_freeLists[binding].capacity());
+  VkWriteDescriptorSet write{
+      .sType            = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+      .pNext            = nullptr,
+      .dstSet           = m_set,
+      .dstBinding       = binding,
+      .dstArrayElement  = handle,
+      .descriptorCount  = 1,
+      .descriptorType   = BINDING_TYPES[binding],
+      .pImageInfo       = pImageInfo,
+      .pBufferInfo      = pBufferInfo,
+      .pTexelBufferView = nullptr,
+  };
+  std::lock_guard lock(m_writeMutex);
+  vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+}
+
+u32 BindlessHeap::addTexture(VkDevice device, VkImageView view,
+                             VkImageLayout layout) {
+  u32 handle = m_freeLists[Textures].acquire();
+  if (handle == IndexFreeList::INVALID) {
+    return handle;
+  }
+  updateTexture(device, handle, view, layout);
+  return handle;
+}
+
+u32 BindlessHeap::addSampler(VkDevice device, VkSampler sampler) {
+  u32 handle = m_freeLists[Samplers].acquire();
+  if (handle == IndexFreeList::INVALID) {
+    return handle;
+  }
+  VkDescriptorImageInfo info{sampler, VK_NULL_HANDLE,
+                             VK_IMAGE_LAYOUT_UNDEFINED};
+  write(device, Samplers, handle, &info, nullptr);
+  return handle;
+}
+
+u32 BindlessHeap::addStorageBuffer(VkDevice device, VkBuffer buffer,
+                                   VkDeviceSize offset, VkDeviceSize range) {
+  u32 handle = m_freeLists[StorageBuffers].acquire();
+  if (handle == IndexFreeList::INVALID) {
+    return handle;
+  }
+  updateStorageBuffer(device, handle, buffer, offset, range);
+  return handle;
+}
+
+void BindlessHeap::updateTexture(VkDevice device, u32 handle,
+                                 VkImageView view, VkImageLayout layout) {
+  VkDescriptorImageInfo info{VK_NULL_HANDLE, view, layout};
+  write(device, Textures, handle, &info, nullptr);
+}
+
+void BindlessHeap::updateStorageBuffer(VkDevice device, u32 handle,
+                                       VkBuffer buffer, VkDeviceSize offset,
+                                       VkDeviceSize range) {
+  VkDescriptorBufferInfo info{buffer, offset, range};
+  write(device, StorageBuffers, handle, nullptr, &info);
+}
+
+void BindlessHeap::release(Binding binding, u32 handle) {
+  // partially bound: the stale descriptor stays until the slot is reused
+  m_freeLists[binding].release(handle);
+}
+
+void BindlessHeap::bind(VkCommandBuffer cmd, VkPipelineBindPoint bindPoint,
+                        VkPipelineLayout pipelineLayout, u32 setIndex) const {
+  vkCmdBindDescriptorSets(cmd, bindPoint, pipelineLayout, setIndex, 1, &m_set,
+                          0, nullptr);
+}
+} // namespace ezvk
@@ -0,0 +1,117 @@
+#pragma once
+#include "common.hpp"
+
+#include "Descriptor.hpp"
+#include "DescriptorCache.hpp"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+namespace ezvk {
+// Lock-free stack of free indices in [0, capacity). The head carries a tag
+// that changes on every push and pop, so a stale compare-exchange fails
+// instead of corrupting the list (ABA).
+class IndexFreeList {
+public:
+  static constexpr u32 INVALID = ~0u;
+
+  void create(u32 capacity);
+
+  // INVALID when every index is taken
+  [[nodiscard]] u32 acquire();
+  void              release(u32 index);
+
+  u32 capacity() const {
+    return m_capacity;
+  }
+
+private:
+  std::unique_ptr<std::atomic<u32>[]> m_next;
+  // tag << 32 | index of the first free index
+  std::atomic<u64> m_head;
+  // indices at or past this one were never handed out
+  std::atomic<u32> m_unused;
+  u32              m_capacity;
+};
+
+// One update-after-bind, partially bound descriptor set holding every
+// texture, sampler and storage buffer. Resources get an integer handle that
+// shaders use to index the arrays, so the heap is bound once per command
+// buffer instead of per draw:
+//
+//   layout(set = S, binding = 0) uniform texture2D textures[];
+//   layout(set = S, binding = 1) uniform sampler samplers[];
+//   layout(set = S, binding = 2) buffer Buffers { ... } buffers[];
+//
+// Handles are allocated and released without locking; descriptor writes
+// take a short lock since the set needs external synchronization. Release a
+// handle only after the GPU work that uses it has completed.
+class BindlessHeap {
+public:
+  enum Binding : u32 {
+    Textures,
+    Samplers,
+    StorageBuffers,
+    BindingCount,
+  };
+
+  struct Capacity {
+    u32 textures{16384};
+    u32 samplers{256};
+    u32 storageBuffers{16384};
+  };
+
+  // merge into Features12 (Extensions.hpp) with the other 1.2 features the
+  // device needs; passing it to set_required_features_12 directly next to
+  // another 1.2 feature struct chains both, which is invalid
+  static VkPhysicalDeviceVulkan12Features requiredFeatures();
+
+  // capacities are clamped to the device's update-after-bind limits
+  void create(VkPhysicalDevice gpu, VkDevice device, LayoutCache& layouts,
+              Capacity capacity = {});
+  void destroy(VkDevice device);
+
+  // Return IndexFreeList::INVALID, without writing anything, when the
+  // binding is full; callers must check before handing the handle to
+  // shaders.
+  [[nodiscard]] u32 addTexture(VkDevice device, VkImageView view,
+                               VkImageLayout layout =
+                                   VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+  [[nodiscard]] u32 addSampler(VkDevice device, VkSampler sampler);
+  [[nodiscard]] u32 addStorageBuffer(VkDevice device, VkBuffer buffer,
+                                     VkDeviceSize offset = 0,
+                                     VkDeviceSize range  = VK_WHOLE_SIZE);
+  // rewrites the descriptor behind an existing handle
+  void updateTexture(VkDevice device, u32 handle, VkImageView view,
+                     VkImageLayout layout);
+  void updateStorageBuffer(VkDevice device, u32 handle, VkBuffer buffer,
+                           VkDeviceSize offset, VkDeviceSize range);
+
+  void release(Binding binding, u32 handle);
+
+  void bind(VkCommandBuffer cmd, VkPipelineBindPoint bindPoint,
+            VkPipelineLayout pipelineLayout, u32 setIndex) const;
+
+  LayoutCache::SetLayoutHandle const& setLayout() const {
+    return m_setLayout;
+  }
+  VkDescriptorSet set() const {
+    return m_set;
+  }
+  u32 capacity(Binding binding) const {
+    return m_freeLists[binding].capacity();
+  }
+
+private:
+  void write(VkDevice device, Binding binding, u32 handle,
+             const VkDescriptorImageInfo*  pImageInfo,
+             const VkDescriptorBufferInfo* pBufferInfo);
+
+  LayoutCache::SetLayoutHandle m_setLayout;
+  DescriptorPool               m_pool;
+  VkDescriptorSet              m_set;
+  IndexFreeList                m_freeLists[BindingCount];
+  std::mutex                   m_writeMutex;
+};
+} // namespace ezvk
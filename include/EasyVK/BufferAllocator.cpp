@@ -93,6 +93,16 @@ void AllocatedBuffer::copyTo(AllocatedBuffer& dstBuffer, VkDevice device,
   stagingCmdBuffer.free(device, pool);
 }
 
+void AllocatedBuffer::recordCopyTo(CommandBuffer&   cmd,
+                                   AllocatedBuffer& dstBuffer) {
+  VkBufferCopy copyRegion{
+      .srcOffset = 0,
+      .dstOffset = 0,
+      .size      = std::min(size, dstBuffer.size),
+  };
+  cmd.copyBuffer(this->buffer, dstBuffer.buffer, 1, &copyRegion);
+}
+
 void AllocatedBuffer::copyToImage(AllocatedImage&    dstImage,
                                   VkImageLayout      dstImageLayout,
                                   VkBufferImageCopy& copyRegion,
@@ -2,6 +2,8 @@
 #include "common.hpp"
 
 #include "Command.hpp"
+
+#include <concepts>
 namespace ezvk {
 
 static inline VkImageSubresourceRange
@@ -42,6 +44,16 @@ struct Sampler {
 
 class BufferAllocator;
 
+// The draw count of an indirect buffer is bound as a storage buffer by the
+// culling pass, so its offset must satisfy minStorageBufferOffsetAlignment,
+// which the spec caps at 256 on every device.
+static constexpr VkDeviceSize INDIRECT_COUNT_ALIGNMENT = 256;
+
+template <typename T>
+concept IndirectCommand = std::same_as<T, VkDrawIndirectCommand> ||
+                          std::same_as<T, VkDrawIndexedIndirectCommand> ||
+                          std::same_as<T, VkDispatchIndirectCommand>;
+
 struct AllocatedImage {
   VkImage       image;
   VmaAllocation allocation;
@@ -54,9 +66,13 @@ struct AllocatedBuffer {
   VkBuffer      buffer;
   VmaAllocation allocation;
   size_t        size;
+  // set by createIndirectBuffer() when a draw count is reserved
+  VkDeviceSize countOffset{0};
 
   void copyTo(AllocatedBuffer& dstBuffer, VkDevice device, CommandPool pool,
               VkQueue transferQueue);
+  // records the copy only, so it can be batched with other work
+  void recordCopyTo(CommandBuffer& cmd, AllocatedBuffer& dstBuffer);
   void copyToImage(AllocatedImage& dstImage, VkImageLayout dstImageLayout,
                    VkBufferImageCopy& copyRegion, VkDevice device,
                    CommandPool pool, VkQueue transferQueue);
@@ -64,6 +80,27 @@ struct AllocatedBuffer {
   void transferMemory(BufferAllocator& allocator, void* const data,
                       size_t size);
 
+  // typed views over an indirect argument buffer
+  template <IndirectCommand T>
+  u32 indirectCapacity() const {
+    // commands stop at the draw count, padding included
+    return u32((countOffset != 0 ? countOffset : size) / sizeof(T));
+  }
+  template <IndirectCommand T>
+  VkDeviceSize indirectOffset(u32 index) const {
+    assert(index < indirectCapacity<T>());
+    return VkDeviceSize(index) * sizeof(T);
+  }
+  template <IndirectCommand T>
+  VkDeviceSize indirectCountOffset() const {
+    assert(countOffset != 0 && "buffer was created without a draw count");
+    return countOffset;
+  }
+  template <IndirectCommand T>
+  VkDescriptorBufferInfo indirectDescriptor(u32 first = 0) const {
+    return {buffer, indirectOffset<T>(first), VK_WHOLE_SIZE};
+  }
+
   EZVK_CONVERT_OP(VkBuffer, buffer);
 };
 
@@ -111,6 +148,33 @@ public:
     vmaInvalidateAllocation(m_allocator, buffer.allocation, 0, buffer.size);
   }
 
+  // Device-local argument buffer that compute shaders can write and indirect
+  // commands can consume. A trailing u32 draw count can be reserved for the
+  // *IndirectCount commands; it lives at indirectCountOffset<T>(), rounded
+  // up to INDIRECT_COUNT_ALIGNMENT.
+  template <IndirectCommand T>
+  [[nodiscard]] AllocatedBuffer
+  createIndirectBuffer(u32 capacity, bool withCount = false,
+                       VkBufferUsageFlags extraUsage = 0) {
+    assert(capacity > 0);
+    VkDeviceSize bufferSize  = VkDeviceSize(capacity) * sizeof(T);
+    VkDeviceSize countOffset = 0;
+    if (withCount) {
+      countOffset = (bufferSize + INDIRECT_COUNT_ALIGNMENT - 1) &
+                    ~(INDIRECT_COUNT_ALIGNMENT - 1);
+      bufferSize  = countOffset + sizeof(u32);
+    }
+    auto buffer = createBufferExclusive(
+        bufferSize,
+        VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT | extraUsage,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    buffer.countOffset = countOffset;
+    return buffer;
+  }
+
   template <typename T>
   [[nodiscard]] AllocatedBuffer createBuffer(std::vector<T>&    vec,
                                              VkBufferUsageFlags bufferUsage,
@@ -1,6 +1,97 @@
 #include "Command.hpp"
+#include "Profiler.hpp"
+#include "Query.hpp"
 
 namespace ezvk {
+void BindStateCache::clear() {
+  for (auto& bindPoint : bindPoints) {
+    bindPoint.pipeline = VK_NULL_HANDLE;
+    bindPoint.layout   = VK_NULL_HANDLE;
+    std::fill(std::begin(bindPoint.sets), std::end(bindPoint.sets),
+              VK_NULL_HANDLE);
+  }
+  std::fill(std::begin(vertexBuffers), std::end(vertexBuffers),
+            VK_NULL_HANDLE);
+  std::fill(std::begin(vertexOffsets), std::end(vertexOffsets), 0);
+  indexBuffer = VK_NULL_HANDLE;
+  indexOffset = 0;
+  indexType   = VK_INDEX_TYPE_MAX_ENUM;
+  pushConstants.layout    = VK_NULL_HANDLE;
+  pushConstants.validMask = 0;
+}
+
+u32 BindStateCache::slot(VkPipelineBindPoint bindPoint) {
+  switch (bindPoint) {
+  case VK_PIPELINE_BIND_POINT_GRAPHICS:
+    return 0;
+  case VK_PIPELINE_BIND_POINT_COMPUTE:
+    return 1;
+  default:
+    return 2;
+  }
+}
+
+static VkRenderingAttachmentInfo
+renderingAttachment(VkImageView view, VkImageLayout layout,
+                    VkAttachmentLoadOp loadOp, VkAttachmentStoreOp storeOp,
+                    VkClearValue clear) {
+  return {
+      .sType       = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+      .pNext       = nullptr,
+      .imageView   = view,
+      .imageLayout = layout,
+      .resolveMode = VK_RESOLVE_MODE_NONE,
+      .loadOp      = loadOp,
+      .storeOp     = storeOp,
+      .clearValue  = clear,
+  };
+}
+
+RenderingInfo& RenderingInfo::addColor(VkImageView view,
+                                       VkAttachmentLoadOp  loadOp,
+                                       VkAttachmentStoreOp storeOp,
+                                       VkClearColorValue   clear,
+                                       VkImageLayout       layout) {
+  colorAttachments.push_back(
+      renderingAttachment(view, layout, loadOp, storeOp, {.color = clear}));
+  return *this;
+}
+
+RenderingInfo& RenderingInfo::setDepth(VkImageView view,
+                                       VkAttachmentLoadOp       loadOp,
+                                       VkAttachmentStoreOp      storeOp,
+                                       VkClearDepthStencilValue clear,
+                                       VkImageLayout            layout) {
+  depthAttachment = renderingAttachment(view, layout, loadOp, storeOp,
+                                        {.depthStencil = clear});
+  return *this;
+}
+
+RenderingInfo& RenderingInfo::setStencil(VkImageView view,
+                                         VkAttachmentLoadOp       loadOp,
+                                         VkAttachmentStoreOp      storeOp,
+                                         VkClearDepthStencilValue clear,
+                                         VkImageLayout            layout) {
+  stencilAttachment = renderingAttachment(view, layout, loadOp, storeOp,
+                                          {.depthStencil = clear});
+  return *this;
+}
+
+VkRenderingInfo RenderingInfo::info() const {
+  return {
+      .sType                = VK_STRUCTURE_TYPE_RENDERING_INFO,
+      .pNext                = nullptr,
+      .flags                = 0,
+      .renderArea           = renderArea,
+      .layerCount           = layerCount,
+      .viewMask             = 0,
+      .colorAttachmentCount = u32(colorAttachments.size()),
+      .pColorAttachments    = colorAttachments.data(),
+      .pDepthAttachment     = depthAttachment ? &*depthAttachment : nullptr,
+      .pStencilAttachment   = stencilAttachment ? &*stencilAttachment : nullptr,
+  };
+}
+
 void CommandPool::create(VkDevice device, VkCommandPoolCreateFlags flag,
                          u32 queueIndex) {
   VkCommandPoolCreateInfo CI{
@@ -50,6 +141,7 @@ void CommandBuffer::begin(
   };
   auto result = vkBeginCommandBuffer(cmdBuffer, &BI);
   assert(result == VK_SUCCESS);
+  bindState.clear();
 }
 void CommandBuffer::end() {
   vkEndCommandBuffer(cmdBuffer);
@@ -61,15 +153,67 @@ CommandBuffer::beginRenderPass(VkRenderPassBeginInfo* pRenderPassBI,
   vkCmdBeginRenderPass(cmdBuffer, pRenderPassBI, contents);
   return *this;
 }
+CommandBuffer&
+CommandBuffer::beginRenderPass(VkRenderPassBeginInfo*       pRenderPassBI,
+                               std::span<const VkImageView> attachments,
+                               VkSubpassContents            contents) {
+  VkRenderPassAttachmentBeginInfo attachmentBI{
+      .sType           = VK_STRUCTURE_TYPE_RENDER_PASS_ATTACHMENT_BEGIN_INFO,
+      .pNext           = pRenderPassBI->pNext,
+      .attachmentCount = u32(attachments.size()),
+      .pAttachments    = attachments.data(),
+  };
+  VkRenderPassBeginInfo renderPassBI = *pRenderPassBI;
+  renderPassBI.pNext                 = &attachmentBI;
+  vkCmdBeginRenderPass(cmdBuffer, &renderPassBI, contents);
+  return *this;
+}
 CommandBuffer& CommandBuffer::endRenderPass() {
   vkCmdEndRenderPass(cmdBuffer);
   return *this;
 }
 
+CommandBuffer&
+CommandBuffer::beginRendering(DynamicRendering const& ext,
+                              const VkRenderingInfo*  pRenderingInfo) {
+  assert(ext.supported());
+  ext.fpBegin(cmdBuffer, pRenderingInfo);
+  return *this;
+}
+CommandBuffer& CommandBuffer::endRendering(DynamicRendering const& ext) {
+  assert(ext.supported());
+  ext.fpEnd(cmdBuffer);
+  return *this;
+}
+
 CommandBuffer& CommandBuffer::bindVertexBuffers(u32             firstBinding,
                                                 u32             bindingCount,
                                                 const VkBuffer* pBuffers,
                                                 const VkDeviceSize* pOffsets) {
+  if (bindState.enabled &&
+      firstBinding + bindingCount <= BindStateCache::MAX_VERTEX_BINDINGS) {
+    bool redundant = true;
+    for (u32 i = 0; i < bindingCount; ++i) {
+      u32 binding = firstBinding + i;
+      if (bindState.vertexBuffers[binding] != pBuffers[i] ||
+          bindState.vertexOffsets[binding] != pOffsets[i]) {
+        redundant                        = false;
+        bindState.vertexBuffers[binding] = pBuffers[i];
+        bindState.vertexOffsets[binding] = pOffsets[i];
+      }
+    }
+    if (redundant) {
+      bindState.skipped++;
+      return *this;
+    }
+  } else if (bindState.enabled) {
+    // past the tracked range: forget the slots this bind overwrites
+    for (u32 binding = firstBinding;
+         binding < BindStateCache::MAX_VERTEX_BINDINGS; ++binding) {
+      bindState.vertexBuffers[binding] = VK_NULL_HANDLE;
+    }
+  }
+  bindState.issued++;
   vkCmdBindVertexBuffers(cmdBuffer, firstBinding, bindingCount, pBuffers,
                          pOffsets);
   return *this;
@@ -83,6 +227,17 @@ CommandBuffer& CommandBuffer::bindVertexBuffer(VkBuffer buffer) {
 CommandBuffer& CommandBuffer::bindIndexBuffer(VkBuffer    buffer,
                                               VkIndexType indexType,
                                               size_t      offset) {
+  if (bindState.enabled) {
+    if (bindState.indexBuffer == buffer && bindState.indexOffset == offset &&
+        bindState.indexType == indexType) {
+      bindState.skipped++;
+      return *this;
+    }
+    bindState.indexBuffer = buffer;
+    bindState.indexOffset = offset;
+    bindState.indexType   = indexType;
+  }
+  bindState.issued++;
   vkCmdBindIndexBuffer(cmdBuffer, buffer, offset, indexType);
   return *this;
 }
@@ -94,15 +249,30 @@ CommandBuffer& CommandBuffer::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer,
   return *this;
 }
 
+CommandBuffer& CommandBuffer::fillBuffer(VkBuffer dstBuffer,
+                                         VkDeviceSize dstOffset,
+                                         VkDeviceSize size, u32 data) {
+  vkCmdFillBuffer(cmdBuffer, dstBuffer, dstOffset, size, data);
+  return *this;
+}
+
 CommandBuffer& CommandBuffer::bindPipeline(VkPipelineBindPoint bindPoint,
                                            VkPipeline          pipeline) {
+  if (bindState.enabled) {
+    auto& state = bindState.bindPoints[BindStateCache::slot(bindPoint)];
+    if (state.pipeline == pipeline) {
+      bindState.skipped++;
+      return *this;
+    }
+    state.pipeline = pipeline;
+  }
+  bindState.issued++;
   vkCmdBindPipeline(cmdBuffer, bindPoint, pipeline);
   return *this;
 }
 
 CommandBuffer& CommandBuffer::bindPipelineGraphic(VkPipeline pipeline) {
-  vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
-  return *this;
+  return bindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
 }
 
 CommandBuffer& CommandBuffer::draw(u32 vertexCount, u32 instanceCount,
@@ -119,11 +289,96 @@ CommandBuffer& CommandBuffer::drawIndexed(u32 indexCount, u32 instanceCount,
   return *this;
 }
 
+CommandBuffer& CommandBuffer::drawIndirect(VkBuffer buffer, VkDeviceSize offset,
+                                           u32 drawCount, u32 stride) {
+  vkCmdDrawIndirect(cmdBuffer, buffer, offset, drawCount, stride);
+  return *this;
+}
+
+CommandBuffer& CommandBuffer::drawIndexedIndirect(VkBuffer     buffer,
+                                                  VkDeviceSize offset,
+                                                  u32 drawCount, u32 stride) {
+  vkCmdDrawIndexedIndirect(cmdBuffer, buffer, offset, drawCount, stride);
+  return *this;
+}
+
+VkPhysicalDeviceVulkan12Features CommandBuffer::drawIndirectCountFeatures() {
+  return {
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+      .pNext = nullptr,
+      .drawIndirectCount = VK_TRUE,
+  };
+}
+
+CommandBuffer& CommandBuffer::drawIndirectCount(VkBuffer     buffer,
+                                                VkDeviceSize offset,
+                                                VkBuffer     countBuffer,
+                                                VkDeviceSize countBufferOffset,
+                                                u32 maxDrawCount, u32 stride) {
+  vkCmdDrawIndirectCount(cmdBuffer, buffer, offset, countBuffer,
+                         countBufferOffset, maxDrawCount, stride);
+  return *this;
+}
+
+CommandBuffer& CommandBuffer::drawIndexedIndirectCount(
+    VkBuffer buffer, VkDeviceSize offset, VkBuffer countBuffer,
+    VkDeviceSize countBufferOffset, u32 maxDrawCount, u32 stride) {
+  vkCmdDrawIndexedIndirectCount(cmdBuffer, buffer, offset, countBuffer,
+                                countBufferOffset, maxDrawCount, stride);
+  return *this;
+}
+
+CommandBuffer& CommandBuffer::indirectArgumentBarrier(VkBuffer     buffer,
+                                                      VkDeviceSize offset,
+                                                      VkDeviceSize size) {
+  VkBufferMemoryBarrier barrier{
+      .sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+      .pNext               = nullptr,
+      .srcAccessMask       = VK_ACCESS_SHADER_WRITE_BIT,
+      .dstAccessMask       = VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
+      .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .buffer              = buffer,
+      .offset              = offset,
+      .size                = size,
+  };
+  return pipelineBufferBarrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                               VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1,
+                               &barrier);
+}
+
 CommandBuffer&
 CommandBuffer::bindDescriptorSet(VkPipelineBindPoint bindPoint,
                                  VkPipelineLayout layout, u32 firstSet,
                                  u32 setCount, VkDescriptorSet* pDescriptorSets,
                                  u32 dynamicOffsetCount, u32* pDynamicOffsets) {
+  if (bindState.enabled && firstSet + setCount <= BindStateCache::MAX_SETS) {
+    auto& state = bindState.bindPoints[BindStateCache::slot(bindPoint)];
+    if (state.layout != layout) {
+      // conservatively forget sets bound through another layout
+      std::fill(std::begin(state.sets), std::end(state.sets), VK_NULL_HANDLE);
+      state.layout = layout;
+    }
+    // dynamic offsets are not tracked, such binds are always issued
+    bool redundant = dynamicOffsetCount == 0;
+    for (u32 i = 0; i < setCount; ++i) {
+      if (state.sets[firstSet + i] != pDescriptorSets[i]) {
+        redundant = false;
+      }
+      state.sets[firstSet + i] =
+          dynamicOffsetCount == 0 ? pDescriptorSets[i] : VK_NULL_HANDLE;
+    }
+    if (redundant) {
+      bindState.skipped++;
+      return *this;
+    }
+  } else if (bindState.enabled) {
+    // past the tracked range: forget everything bound at this bind point
+    auto& state  = bindState.bindPoints[BindStateCache::slot(bindPoint)];
+    state.layout = VK_NULL_HANDLE;
+    std::fill(std::begin(state.sets), std::end(state.sets), VK_NULL_HANDLE);
+  }
+  bindState.issued++;
   vkCmdBindDescriptorSets(cmdBuffer, bindPoint, layout, firstSet, setCount,
                           pDescriptorSets, dynamicOffsetCount, pDynamicOffsets);
   return *this;
@@ -135,4 +390,60 @@ CommandBuffer& CommandBuffer::bindDescriptorSetNoDynamic(
                            pDescriptorSets, 0, nullptr);
 }
 
+CommandBuffer& CommandBuffer::beginZone(ccstr name) {
+  if (profiler) {
+    profiler->beginZone(cmdBuffer, name);
+  }
+  return *this;
+}
+CommandBuffer& CommandBuffer::endZone() {
+  if (profiler) {
+    profiler->endZone(cmdBuffer);
+  }
+  return *this;
+}
+
+CommandBuffer& CommandBuffer::resetQueryPool(VkQueryPool queryPool,
+                                             u32 firstQuery, u32 queryCount) {
+  vkCmdResetQueryPool(cmdBuffer, queryPool, firstQuery, queryCount);
+  return *this;
+}
+CommandBuffer& CommandBuffer::beginQuery(VkQueryPool queryPool, u32 query,
+                                         VkQueryControlFlags flags) {
+  vkCmdBeginQuery(cmdBuffer, queryPool, query, flags);
+  return *this;
+}
+CommandBuffer& CommandBuffer::endQuery(VkQueryPool queryPool, u32 query) {
+  vkCmdEndQuery(cmdBuffer, queryPool, query);
+  return *this;
+}
+CommandBuffer& CommandBuffer::copyQueryPoolResults(
+    VkQueryPool queryPool, u32 firstQuery, u32 queryCount, VkBuffer dstBuffer,
+    VkDeviceSize dstOffset, VkDeviceSize stride, VkQueryResultFlags flags) {
+  vkCmdCopyQueryPoolResults(cmdBuffer, queryPool, firstQuery, queryCount,
+                            dstBuffer, dstOffset, stride, flags);
+  return *this;
+}
+
+CommandBuffer& CommandBuffer::beginConditionalRendering(
+    ConditionalRendering const& ext, VkBuffer buffer, VkDeviceSize offset,
+    bool inverted) {
+  assert(ext.supported());
+  VkConditionalRenderingBeginInfoEXT BI{
+      .sType  = VK_STRUCTURE_TYPE_CONDITIONAL_RENDERING_BEGIN_INFO_EXT,
+      .pNext  = nullptr,
+      .buffer = buffer,
+      .offset = offset,
+      .flags  = inverted ? VK_CONDITIONAL_RENDERING_INVERTED_BIT_EXT : 0u,
+  };
+  ext.fpBegin(cmdBuffer, &BI);
+  return *this;
+}
+CommandBuffer&
+CommandBuffer::endConditionalRendering(ConditionalRendering const& ext) {
+  assert(ext.supported());
+  ext.fpEnd(cmdBuffer);
+  return *this;
+}
+
 } // namespace ezvk
\ No newline at end of file
@@ -1,7 +1,16 @@
 #pragma once
 #include "common.hpp"
 
+#include "Extensions.hpp"
+#include "PushConstants.hpp"
+
+#include <cstring>
+#include <span>
+
 namespace ezvk {
+class GpuProfiler;
+struct ConditionalRendering;
+
 struct CommandPool {
   VkCommandPool cmdPool;
 
@@ -11,8 +20,83 @@ struct CommandPool {
   EZVK_CONVERT_OP(VkCommandPool, cmdPool);
   EZVK_ADDRESS_OP(VkCommandPool, cmdPool);
 };
+// Last bindings seen by a CommandBuffer, used to drop redundant vkCmdBind*
+// calls when the state cache is enabled.
+struct BindStateCache {
+  static constexpr u32 BIND_POINT_COUNT    = 3;
+  static constexpr u32 MAX_SETS            = 8;
+  static constexpr u32 MAX_VERTEX_BINDINGS = 16;
+
+  struct BindPoint {
+    VkPipeline       pipeline;
+    VkPipelineLayout layout;
+    VkDescriptorSet  sets[MAX_SETS];
+  };
+
+  bool         enabled{false};
+  BindPoint    bindPoints[BIND_POINT_COUNT];
+  VkBuffer     vertexBuffers[MAX_VERTEX_BINDINGS];
+  VkDeviceSize vertexOffsets[MAX_VERTEX_BINDINGS];
+  VkBuffer     indexBuffer;
+  VkDeviceSize indexOffset;
+  VkIndexType  indexType;
+
+  // Last values written through CommandBuffer::pushConstants<T>, one valid
+  // bit per 4-byte word. Always active, independent of `enabled`.
+  struct PushConstantShadow {
+    VkPipelineLayout   layout;
+    VkShaderStageFlags stages;
+    u32                validMask;
+    u8                 data[MIN_PUSH_CONSTANT_SIZE];
+  } pushConstants;
+
+  // bind calls forwarded to Vulkan / dropped as redundant
+  u64 issued{0};
+  u64 skipped{0};
+  // pushConstants<T> calls forwarded / dropped, counted apart from binds
+  u64 pushIssued{0};
+  u64 pushSkipped{0};
+
+  void clear();
+  // graphics, compute and ray tracing map to 0, 1, 2
+  static u32 slot(VkPipelineBindPoint bindPoint);
+};
+
+// Attachment description for dynamic rendering (VK_KHR_dynamic_rendering,
+// see DynamicRendering). The VkRenderingInfo returned by info() points into
+// this object.
+struct RenderingInfo {
+  VkRect2D                                 renderArea;
+  u32                                      layerCount{1};
+  std::vector<VkRenderingAttachmentInfo>   colorAttachments;
+  std::optional<VkRenderingAttachmentInfo> depthAttachment;
+  std::optional<VkRenderingAttachmentInfo> stencilAttachment;
+
+  RenderingInfo() = default;
+  RenderingInfo(VkExtent2D extent) : renderArea{{0, 0}, extent} {}
+
+  RenderingInfo&
+  addColor(VkImageView view, VkAttachmentLoadOp loadOp,
+           VkAttachmentStoreOp storeOp, VkClearColorValue clear = {},
+           VkImageLayout layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+  RenderingInfo& setDepth(
+      VkImageView view, VkAttachmentLoadOp loadOp,
+      VkAttachmentStoreOp      storeOp,
+      VkClearDepthStencilValue clear  = {1.0f, 0},
+      VkImageLayout layout = VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL);
+  RenderingInfo& setStencil(
+      VkImageView view, VkAttachmentLoadOp loadOp,
+      VkAttachmentStoreOp      storeOp,
+      VkClearDepthStencilValue clear  = {1.0f, 0},
+      VkImageLayout layout = VK_IMAGE_LAYOUT_STENCIL_ATTACHMENT_OPTIMAL);
+
+  VkRenderingInfo info() const;
+};
+
 struct CommandBuffer {
   VkCommandBuffer cmdBuffer;
+  GpuProfiler*    profiler{nullptr};
+  BindStateCache  bindState;
 
   void alloc(VkDevice device, VkCommandPool cmdPool,
              VkCommandBufferLevel level);
@@ -23,10 +107,34 @@ struct CommandBuffer {
   void           begin(VkCommandBufferUsageFlags             flag,
                        const VkCommandBufferInheritanceInfo* pInheritanceInfo = nullptr);
   void           end();
+  // The cache is cleared on begin(); call invalidateState() after binding
+  // anything through the raw VkCommandBuffer.
+  void enableStateCache(bool enable = true) {
+    bindState.enabled = enable;
+    bindState.clear();
+  }
+  void invalidateState() {
+    bindState.clear();
+  }
+
   CommandBuffer& beginRenderPass(VkRenderPassBeginInfo* pRenderPassBI,
                                  VkSubpassContents      contents);
+  // For imageless framebuffers: `attachments` are bound in place of the
+  // views a regular framebuffer bakes in.
+  CommandBuffer& beginRenderPass(VkRenderPassBeginInfo*       pRenderPassBI,
+                                 std::span<const VkImageView> attachments,
+                                 VkSubpassContents            contents);
   CommandBuffer& endRenderPass();
 
+  CommandBuffer& beginRendering(DynamicRendering const& ext,
+                                const VkRenderingInfo*  pRenderingInfo);
+  CommandBuffer& beginRendering(DynamicRendering const& ext,
+                                RenderingInfo const&    renderingInfo) {
+    VkRenderingInfo info = renderingInfo.info();
+    return beginRendering(ext, &info);
+  }
+  CommandBuffer& endRendering(DynamicRendering const& ext);
+
   CommandBuffer& bindVertexBuffer(VkBuffer buffer);
   CommandBuffer& bindVertexBuffers(u32 firstBinding, u32 bindingCount,
                                    const VkBuffer*     pBuffers,
@@ -43,11 +151,65 @@ struct CommandBuffer {
                              u32 vertexOffset, u32 firstInstance);
   CommandBuffer& copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer,
                             u32 regionCount, const VkBufferCopy* pRegions);
+  CommandBuffer& fillBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset,
+                            VkDeviceSize size, u32 data);
+
+  // argument buffers may be written by earlier commands, e.g. a compute pass
+  CommandBuffer& drawIndirect(VkBuffer buffer, VkDeviceSize offset,
+                              u32 drawCount,
+                              u32 stride = sizeof(VkDrawIndirectCommand));
+  CommandBuffer&
+  drawIndexedIndirect(VkBuffer buffer, VkDeviceSize offset, u32 drawCount,
+                      u32 stride = sizeof(VkDrawIndexedIndirectCommand));
+  // The *Count variants need the Vulkan 1.2 drawIndirectCount feature, see
+  // drawIndirectCountFeatures(). The draw count is read from countBuffer and
+  // clamped to maxDrawCount.
+  static VkPhysicalDeviceVulkan12Features drawIndirectCountFeatures();
+  CommandBuffer&
+  drawIndirectCount(VkBuffer buffer, VkDeviceSize offset, VkBuffer countBuffer,
+                    VkDeviceSize countBufferOffset, u32 maxDrawCount,
+                    u32 stride = sizeof(VkDrawIndirectCommand));
+  CommandBuffer&
+  drawIndexedIndirectCount(VkBuffer buffer, VkDeviceSize offset,
+                           VkBuffer countBuffer, VkDeviceSize countBufferOffset,
+                           u32 maxDrawCount,
+                           u32 stride = sizeof(VkDrawIndexedIndirectCommand));
+  // makes arguments written by a compute shader visible to indirect commands
+  CommandBuffer& indirectArgumentBarrier(VkBuffer     buffer,
+                                         VkDeviceSize offset = 0,
+                                         VkDeviceSize size   = VK_WHOLE_SIZE);
+
+  // no-ops unless a profiler is attached
+  CommandBuffer& beginZone(ccstr name);
+  CommandBuffer& endZone();
+
+  CommandBuffer& resetQueryPool(VkQueryPool queryPool, u32 firstQuery,
+                                u32 queryCount);
+  CommandBuffer& beginQuery(VkQueryPool queryPool, u32 query,
+                            VkQueryControlFlags flags = 0);
+  CommandBuffer& endQuery(VkQueryPool queryPool, u32 query);
+  CommandBuffer& copyQueryPoolResults(VkQueryPool queryPool, u32 firstQuery,
+                                      u32 queryCount, VkBuffer dstBuffer,
+                                      VkDeviceSize       dstOffset,
+                                      VkDeviceSize       stride,
+                                      VkQueryResultFlags flags);
+
+  // draws recorded in between are discarded on the GPU when the 32-bit
+  // predicate at `offset` is zero (non-zero when `inverted`)
+  CommandBuffer& beginConditionalRendering(ConditionalRendering const& ext,
+                                           VkBuffer     buffer,
+                                           VkDeviceSize offset,
+                                           bool         inverted = false);
+  CommandBuffer& endConditionalRendering(ConditionalRendering const& ext);
 
   CommandBuffer& dispatch(u32 groupX, u32 groupY, u32 groupZ) {
     vkCmdDispatch(cmdBuffer, groupX, groupY, groupZ);
     return *this;
   }
+  CommandBuffer& dispatchIndirect(VkBuffer buffer, VkDeviceSize offset = 0) {
+    vkCmdDispatchIndirect(cmdBuffer, buffer, offset);
+    return *this;
+  }
 
   CommandBuffer& copyBufferToImage(VkBuffer srcBuffer, VkImage dstImage,
                                    VkImageLayout            dstImageLayout,
@@ -67,6 +229,58 @@ struct CommandBuffer {
     return *this;
   }
 
+  // forgets the values pushConstants<T> remembers, so its next push is
+  // never skipped against bytes this call may have overwritten
+  CommandBuffer& pushConstants(VkPipelineLayout layout,
+                               VkShaderStageFlags stages, u32 offset, u32 size,
+                               const void* pValues) {
+    bindState.pushConstants.validMask = 0;
+    vkCmdPushConstants(cmdBuffer, layout, stages, offset, size, pValues);
+    return *this;
+  }
+
+  // Pushes the block described by PushConstants<T>, limited to the words
+  // that differ from what was last pushed through this function with the
+  // same layout. vkCmdPushConstants called directly on cmdBuffer requires
+  // invalidateState().
+  template <typename T>
+  CommandBuffer& pushConstants(VkPipelineLayout layout, const T& value) {
+    using Block  = PushConstants<T>;
+    auto& shadow = bindState.pushConstants;
+    auto  bytes  = reinterpret_cast<const u8*>(&value);
+
+    u32 first = 0, last = Block::size;
+    if (shadow.layout == layout && shadow.stages == Block::stages) {
+      first = Block::size;
+      last  = 0;
+      for (u32 i = 0; i < Block::size; i += 4) {
+        u32 word = (Block::offset + i) / 4;
+        if (!(shadow.validMask & (1u << word)) ||
+            std::memcmp(shadow.data + Block::offset + i, bytes + i, 4) != 0) {
+          first = std::min(first, i);
+          last  = i + 4;
+        }
+      }
+      if (first >= last) {
+        bindState.pushSkipped++;
+        return *this;
+      }
+    } else {
+      shadow.layout    = layout;
+      shadow.stages    = Block::stages;
+      shadow.validMask = 0;
+    }
+    std::memcpy(shadow.data + Block::offset + first, bytes + first,
+                last - first);
+    for (u32 i = first; i < last; i += 4) {
+      shadow.validMask |= 1u << ((Block::offset + i) / 4);
+    }
+    bindState.pushIssued++;
+    vkCmdPushConstants(cmdBuffer, layout, Block::stages, Block::offset + first,
+                       last - first, bytes + first);
+    return *this;
+  }
+
   CommandBuffer& bindDescriptorSet(VkPipelineBindPoint bindPoint,
                                    VkPipelineLayout layout, u32 firstSet,
                                    u32              setCount,
@@ -120,6 +334,33 @@ struct CommandBuffer {
     return *this;
   }
 
+  // VK_KHR_synchronization2, see Synchronization2
+  CommandBuffer& pipelineBarrier2(Synchronization2 const& ext,
+                                  const VkDependencyInfo* pDependencyInfo) {
+    assert(ext.supported());
+    ext.fpCmdPipelineBarrier2(cmdBuffer, pDependencyInfo);
+    return *this;
+  }
+  CommandBuffer&
+  pipelineBarrier2(Synchronization2 const&       ext,
+                   u32                           bufferMemoryBarrierCount,
+                   const VkBufferMemoryBarrier2* pBufferMemoryBarriers,
+                   u32                           imageMemoryBarrierCount,
+                   const VkImageMemoryBarrier2*  pImageMemoryBarriers) {
+    VkDependencyInfo DI{
+        .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+        .pNext                    = nullptr,
+        .dependencyFlags          = 0,
+        .memoryBarrierCount       = 0,
+        .pMemoryBarriers          = nullptr,
+        .bufferMemoryBarrierCount = bufferMemoryBarrierCount,
+        .pBufferMemoryBarriers    = pBufferMemoryBarriers,
+        .imageMemoryBarrierCount  = imageMemoryBarrierCount,
+        .pImageMemoryBarriers     = pImageMemoryBarriers,
+    };
+    return pipelineBarrier2(ext, &DI);
+  }
+
   EZVK_CONVERT_OP(VkCommandBuffer, cmdBuffer);
   EZVK_ADDRESS_OP(VkCommandBuffer, cmdBuffer);
 };
@@ -0,0 +1,110 @@
+#include "Coroutine.hpp"
+
+namespace ezvk {
+void GpuExecutor::destroy() {
+  // suspended coroutines belong to a spawned task, or to a task awaited by
+  // one, so destroying the tasks frees every frame
+  m_pending.clear();
+  m_tasks.clear();
+}
+
+void GpuExecutor::spawn(Task<void>&& task) {
+  auto handle = task.m_handle;
+  m_tasks.push_back(std::move(task));
+  handle.resume();
+  reapTasks();
+}
+
+TimelineAwaitable
+GpuExecutor::submit(Queue& queue, VkCommandBuffer cmd,
+                    std::span<const VkSemaphoreSubmitInfo> waits) {
+  u64  value  = queue.submit(cmd, waits);
+  auto result = queue.flush();
+  assert(result == VK_SUCCESS);
+  return {this, queue.timeline.semaphore, value};
+}
+
+bool GpuExecutor::complete(Pending const& pending) {
+  if (pending.fence != VK_NULL_HANDLE) {
+    return vkGetFenceStatus(m_device, pending.fence) == VK_SUCCESS;
+  }
+  u64  value  = 0;
+  auto result = vkGetSemaphoreCounterValue(m_device, pending.semaphore, &value);
+  assert(result == VK_SUCCESS);
+  return value >= pending.value;
+}
+
+u32 GpuExecutor::poll() {
+  std::vector<std::coroutine_handle<>> ready;
+  auto it = std::stable_partition(
+      m_pending.begin(), m_pending.end(),
+      [this](Pending const& pending) { return !complete(pending); });
+  for (auto resumed = it; resumed != m_pending.end(); ++resumed) {
+    ready.push_back(resumed->handle);
+  }
+  m_pending.erase(it, m_pending.end());
+
+  // resumed coroutines may suspend again and append to m_pending
+  for (auto handle : ready) {
+    handle.resume();
+  }
+  reapTasks();
+  return u32(ready.size());
+}
+
+void GpuExecutor::drain() {
+  std::vector<VkSemaphore> semaphores;
+  std::vector<u64>         values;
+  std::vector<VkFence>     fences;
+  while (!m_pending.empty()) {
+    if (poll() != 0) {
+      continue;
+    }
+    semaphores.clear();
+    values.clear();
+    fences.clear();
+    for (auto const& pending : m_pending) {
+      if (pending.fence != VK_NULL_HANDLE) {
+        fences.push_back(pending.fence);
+      } else {
+        semaphores.push_back(pending.semaphore);
+        values.push_back(pending.value);
+      }
+    }
+    if (!semaphores.empty()) {
+      VkSemaphoreWaitInfo WI{
+          .sType          = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+          .pNext          = nullptr,
+          .flags          = VK_SEMAPHORE_WAIT_ANY_BIT,
+          .semaphoreCount = u32(semaphores.size()),
+          .pSemaphores    = semaphores.data(),
+          .pValues        = values.data(),
+      };
+      vkWaitSemaphores(m_device, &WI, WAIT_SLICE);
+    }
+    if (!fences.empty()) {
+      vkWaitForFences(m_device, u32(fences.size()), fences.data(), VK_FALSE,
+                      semaphores.empty() ? WAIT_SLICE : 0);
+    }
+  }
+  reapTasks();
+}
+
+// Finished tasks are dropped before the first failure is rethrown, so a
+// failed task is reported once and the executor stays usable.
+void GpuExecutor::reapTasks() {
+  std::exception_ptr failure;
+  std::erase_if(m_tasks, [&](Task<void> const& task) {
+    if (!task.done()) {
+      return false;
+    }
+    if (!failure) {
+      failure = task.m_handle.promise().exception;
+    }
+    return true;
+  });
+  if (failure) {
+    std::rethrow_exception(failure);
+  }
+}
+} // namespace ezvk
@@ -0,0 +1,262 @@
+#pragma once
+#include "common.hpp"
+
+#include "BufferAllocator.hpp"
+#include "Queue.hpp"
+#include "SyncStructures.hpp"
+
+#include <coroutine>
+#include <cstring>
+#include <exception>
+
+namespace ezvk {
+template <typename T = void>
+class Task;
+
+namespace detail {
+struct TaskPromiseBase {
+  struct FinalAwaiter {
+    bool await_ready() noexcept {
+      return false;
+    }
+    template <typename Promise>
+    std::coroutine_handle<>
+    await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+      auto continuation = handle.promise().continuation;
+      return continuation ? continuation : std::noop_coroutine();
+    }
+    void await_resume() noexcept {}
+  };
+
+  std::coroutine_handle<> continuation;
+  std::exception_ptr      exception;
+
+  std::suspend_always initial_suspend() noexcept {
+    return {};
+  }
+  FinalAwaiter final_suspend() noexcept {
+    return {};
+  }
+  void unhandled_exception() {
+    exception = std::current_exception();
+  }
+};
+
+template <typename T>
+struct TaskPromise : TaskPromiseBase {
+  std::optional<T> value;
+
+  Task<T> get_return_object();
+  void    return_value(T result) {
+    value = std::move(result);
+  }
+};
+
+template <>
+struct TaskPromise<void> : TaskPromiseBase {
+  Task<void> get_return_object();
+  void       return_void() {}
+};
+} // namespace detail
+
+// Lazily started coroutine. Either co_await it from another Task or hand a
+// Task<void> to GpuExecutor::spawn().
+template <typename T>
+class [[nodiscard]] Task {
+public:
+  using promise_type = detail::TaskPromise<T>;
+  using Handle       = std::coroutine_handle<promise_type>;
+
+  explicit Task(Handle handle) : m_handle(handle) {}
+  Task(Task&& other) noexcept : m_handle(std::exchange(other.m_handle, {})) {}
+  Task& operator=(Task&& other) noexcept {
+    if (this != &other) {
+      if (m_handle) {
+        m_handle.destroy();
+      }
+      m_handle = std::exchange(other.m_handle, {});
+    }
+    return *this;
+  }
+  Task(Task const&)            = delete;
+  Task& operator=(Task const&) = delete;
+  ~Task() {
+    if (m_handle) {
+      m_handle.destroy();
+    }
+  }
+
+  bool done() const {
+    return !m_handle || m_handle.done();
+  }
+
+  auto operator co_await() && noexcept {
+    struct Awaiter {
+      Handle handle;
+
+      bool await_ready() noexcept {
+        return !handle || handle.done();
+      }
+      std::coroutine_handle<>
+      await_suspend(std::coroutine_handle<> continuation) noexcept {
+        handle.promise().continuation = continuation;
+        return handle;
+      }
+      T await_resume() {
+        if (handle.promise().exception) {
+          std::rethrow_exception(handle.promise().exception);
+        }
+        if constexpr (!std::is_void_v<T>) {
+          return std::move(*handle.promise().value);
+        }
+      }
+    };
+    return Awaiter{m_handle};
+  }
+
+private:
+  friend class GpuExecutor;
+  Handle m_handle;
+};
+
+namespace detail {
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object() {
+  return Task<T>{std::coroutine_handle<TaskPromise<T>>::from_promise(*this)};
+}
+inline Task<void> TaskPromise<void>::get_return_object() {
+  return Task<void>{
+      std::coroutine_handle<TaskPromise<void>>::from_promise(*this)};
+}
+} // namespace detail
+
+class GpuExecutor;
+
+// Resumes with the timeline value once the semaphore has reached it.
+struct TimelineAwaitable {
+  GpuExecutor* executor;
+  VkSemaphore  semaphore;
+  u64          value;
+
+  bool await_ready();
+  void await_suspend(std::coroutine_handle<> handle);
+  u64  await_resume() {
+    return value;
+  }
+};
+
+struct FenceAwaitable {
+  GpuExecutor* executor;
+  VkFence      fence;
+
+  bool await_ready();
+  void await_suspend(std::coroutine_handle<> handle);
+  void await_resume() {}
+};
+
+// Resumes with a copy of the first `count` elements of a host-visible
+// buffer once the GPU work writing it has completed.
+template <typename T>
+struct ReadbackAwaitable : TimelineAwaitable {
+  BufferAllocator* allocator;
+  AllocatedBuffer  buffer;
+  u32              count;
+
+  std::vector<T> await_resume() {
+    assert(count * sizeof(T) <= buffer.size);
+    std::vector<T> result(count);
+    void*          mapped;
+    allocator->invalidMappedMemory(buffer);
+    auto mapResult = allocator->mmap(buffer, &mapped);
+    assert(mapResult == VK_SUCCESS);
+    memcpy(result.data(), mapped, count * sizeof(T));
+    allocator->munmap(buffer);
+    return result;
+  }
+};
+
+// Single-threaded executor resuming coroutines suspended on GPU work. Drive
+// it with poll() from the frame loop, or drain() where blocking is fine.
+//
+//   Task<void> upload(GpuExecutor& gpu, Queue& queue, CommandBuffer& cmd) {
+//     u64 value = co_await gpu.submit(queue, cmd);
+//     auto data = co_await gpu.readback<u32>(queue, value, allocator, dst, n);
+//   }
+//   gpu.spawn(upload(gpu, queue, cmd));
+class GpuExecutor {
+public:
+  // upper bound of one blocking wait in drain(), so fences and timelines
+  // can be waited on in turn
+  static constexpr u64 WAIT_SLICE = 1000000; // 1ms
+
+  void create(VkDevice device) {
+    m_device = device;
+  }
+  // destroys the coroutines still suspended
+  void destroy();
+
+  // starts `task`, which then lives until it finishes
+  void spawn(Task<void>&& task);
+
+  // submits and flushes `cmd`, then resumes with its timeline value
+  TimelineAwaitable submit(Queue& queue, VkCommandBuffer cmd,
+                           std::span<const VkSemaphoreSubmitInfo> waits = {});
+  TimelineAwaitable wait(Queue& queue, u64 value) {
+    return {this, queue.timeline.semaphore, value};
+  }
+  TimelineAwaitable wait(TimelineSemaphore const& semaphore, u64 value) {
+    return {this, semaphore.semaphore, value};
+  }
+  FenceAwaitable wait(VkFence fence) {
+    return {this, fence};
+  }
+  template <typename T>
+  ReadbackAwaitable<T> readback(Queue& queue, u64 value,
+                                BufferAllocator& allocator,
+                                AllocatedBuffer buffer, u32 count) {
+    return {{this, queue.timeline.semaphore, value}, &allocator, buffer, count};
+  }
+
+  // resumes every coroutine whose GPU work has completed, returns how many
+  u32  poll();
+  // polls until no coroutine is suspended, blocking in between
+  void drain();
+  bool idle() const {
+    return m_pending.empty() && m_tasks.empty();
+  }
+
+private:
+  friend struct TimelineAwaitable;
+  friend struct FenceAwaitable;
+
+  struct Pending {
+    VkSemaphore             semaphore;
+    u64                     value;
+    VkFence                 fence;
+    std::coroutine_handle<> handle;
+  };
+
+  bool complete(Pending const& pending);
+  void enqueue(Pending pending) {
+    m_pending.push_back(pending);
+  }
+  void reapTasks();
+
+  VkDevice                m_device;
+  std::vector<Pending>    m_pending;
+  std::vector<Task<void>> m_tasks;
+};
+
+inline bool TimelineAwaitable::await_ready() {
+  return executor->complete({semaphore, value, VK_NULL_HANDLE, {}});
+}
+inline void TimelineAwaitable::await_suspend(std::coroutine_handle<> handle) {
+  executor->enqueue({semaphore, value, VK_NULL_HANDLE, handle});
+}
+inline bool FenceAwaitable::await_ready() {
+  return executor->complete({VK_NULL_HANDLE, 0, fence, {}});
+}
+inline void FenceAwaitable::await_suspend(std::coroutine_handle<> handle) {
+  executor->enqueue({VK_NULL_HANDLE, 0, fence, handle});
+}
+} // namespace ezvk
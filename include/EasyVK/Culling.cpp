@@ -0,0 +1,134 @@
+#include "Culling.hpp"
+#include "Shader.hpp"
+
+#include <cmath>
+
+namespace ezvk {
+void GpuCullParams::setProjection(const float* projection, float znear,
+                                  float zfar) {
+  // rows of the column-major matrix
+  auto row = [projection](u32 r, u32 c) { return projection[c * 4 + r]; };
+
+  // x + w < 0 and y + w < 0 planes, normalized by their xyz length
+  float planeX[3]{row(3, 0) + row(0, 0), row(3, 1) + row(0, 1),
+                  row(3, 2) + row(0, 2)};
+  float planeY[3]{row(3, 0) + row(1, 0), row(3, 1) + row(1, 1),
+                  row(3, 2) + row(1, 2)};
+  float lengthX = std::sqrt(planeX[0] * planeX[0] + planeX[1] * planeX[1] +
+                            planeX[2] * planeX[2]);
+  float lengthY = std::sqrt(planeY[0] * planeY[0] + planeY[1] * planeY[1] +
+                            planeY[2] * planeY[2]);
+
+  frustum[0] = planeX[0] / lengthX;
+  frustum[1] = planeX[2] / lengthX;
+  frustum[2] = planeY[1] / lengthY;
+  frustum[3] = planeY[2] / lengthY;
+
+  P00         = row(0, 0);
+  P11         = row(1, 1);
+  this->znear = znear;
+  this->zfar  = zfar;
+}
+
+VkPhysicalDeviceVulkan12Features GpuCuller::requiredFeatures() {
+  return {
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+      .pNext = nullptr,
+      .drawIndirectCount   = VK_TRUE,
+      .samplerFilterMinmax = VK_TRUE,
+  };
+}
+
+void GpuCuller::create(VkDevice device, std::vector<u8>& spirv,
+                       VkPipelineCache cache) {
+  DescriptorSetLayoutBindingList bindingList;
+  bindingList
+      .add(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT)
+      .add(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT)
+      .add(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT)
+      .add(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT)
+      .add(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT)
+      .add(5, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1,
+           VK_SHADER_STAGE_COMPUTE_BIT);
+  auto result = setLayout.create(device, bindingList.bindings);
+  assert(result == VK_SUCCESS);
+
+  result = pipelineLayout.create<GpuCullParams>(device, {setLayout});
+  assert(result == VK_SUCCESS);
+
+  Shader shader;
+  shader.create(device, "gpu cull", VK_SHADER_STAGE_COMPUTE_BIT, spirv);
+
+  ComputePipelineBuilder builder;
+  builder.add(0, shader, pipelineLayout);
+  pipeline = builder.build(device, cache)[0];
+  shader.destroy(device);
+}
+
+void GpuCuller::destroy(VkDevice device) {
+  vkDestroyPipeline(device, pipeline, nullptr);
+  pipelineLayout.destroy(device);
+  setLayout.destroy(device);
+}
+
+void GpuCuller::writeDescriptorSet(VkDevice device, VkDescriptorSet set,
+                                   Bindings const& bindings) {
+  VkDescriptorBufferInfo bufferInfos[]{
+      {bindings.instances, 0, VK_WHOLE_SIZE},
+      {bindings.meshes, 0, VK_WHOLE_SIZE},
+      {bindings.draws, 0, VK_WHOLE_SIZE},
+      {bindings.countBuffer, bindings.countOffset, sizeof(u32)},
+      {bindings.visibleInstances, 0, VK_WHOLE_SIZE},
+  };
+  VkDescriptorImageInfo imageInfo{
+      .sampler     = bindings.pyramidSampler,
+      .imageView   = bindings.depthPyramid,
+      .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+  };
+
+  WriteDescriptorSet writeSets;
+  for (u32 i = 0; i < u32(std::size(bufferInfos)); ++i) {
+    writeSets.addBuffer(set, i, 0, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                        &bufferInfos[i]);
+  }
+  writeSets.addImage(set, 5, 0, 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                     &imageInfo);
+  vkUpdateDescriptorSets(device, u32(writeSets.writeSets.size()),
+                         writeSets.writeSets.data(), 0, nullptr);
+}
+
+void GpuCuller::record(CommandBuffer& cmd, VkDescriptorSet set,
+                       Bindings const& bindings, GpuCullParams const& params) {
+  cmd.fillBuffer(bindings.countBuffer, bindings.countOffset, sizeof(u32), 0);
+
+  VkMemoryBarrier barrier{
+      .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+      .pNext         = nullptr,
+      .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+      .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+  };
+  cmd.pipelineMemoryBarrier(VK_PIPELINE_STAGE_TRANSFER_BIT,
+                            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1,
+                            &barrier);
+
+  cmd.bindPipeline(VK_PIPELINE_BIND_POINT_COMPUTE, pipeline)
+      .bindDescriptorSetNoDynamic(VK_PIPELINE_BIND_POINT_COMPUTE,
+                                  pipelineLayout, 0, 1, &set)
+      .pushConstants(pipelineLayout, params)
+      .dispatch((params.instanceCount + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1);
+
+  barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  barrier.dstAccessMask =
+      VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+  cmd.pipelineMemoryBarrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT |
+                                VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+                            0, 1, &barrier);
+}
+
+void GpuCuller::draw(CommandBuffer& cmd, Bindings const& bindings,
+                     u32 maxDrawCount) {
+  cmd.drawIndexedIndirectCount(bindings.draws, 0, bindings.countBuffer,
+                               bindings.countOffset, maxDrawCount);
+}
+} // namespace ezvk
@@ -0,0 +1,91 @@
+#pragma once
+#include "common.hpp"
+
+#include "Command.hpp"
+#include "Descriptor.hpp"
+#include "PipelineBuilder.hpp"
+
+namespace ezvk {
+// The structs below mirror the std430 layouts declared in Cull.comp.
+
+struct GpuCullInstance {
+  float transform[16]; // column-major model matrix
+  float sphere[4];     // local-space bounding sphere center.xyz, radius
+  u32   meshIndex;
+  u32   pad[3];
+};
+static_assert(sizeof(GpuCullInstance) == 96);
+
+struct GpuCullMesh {
+  u32 indexCount;
+  u32 firstIndex;
+  i32 vertexOffset;
+  u32 pad;
+};
+static_assert(sizeof(GpuCullMesh) == 16);
+
+struct GpuCullParams {
+  static constexpr VkShaderStageFlags pushStages = VK_SHADER_STAGE_COMPUTE_BIT;
+
+  float view[16];   // column-major, view space looks down +Z
+  float frustum[4]; // filled by setProjection()
+  float P00, P11;
+  float znear, zfar;
+  float pyramidWidth, pyramidHeight;
+  u32   instanceCount;
+  u32   occlusionEnabled;
+  u32   maxDraws; // capacity of draws/visibleInstances, extra visible dropped
+
+  // `projection` is column-major and maps +Z view depth to reversed-Z
+  void setProjection(const float* projection, float znear, float zfar);
+};
+
+// Frustum and depth-pyramid culling on the GPU. Visible instances are
+// compacted into VkDrawIndexedIndirectCommands (firstInstance is the instance
+// index) plus a u32 draw count for drawIndexedIndirectCount.
+class GpuCuller {
+public:
+  static constexpr u32 GROUP_SIZE = 64;
+
+  // drawIndirectCount for draw() and samplerFilterMinmax for the pyramid
+  // sampler; merge into Features12 (Extensions.hpp)
+  static VkPhysicalDeviceVulkan12Features requiredFeatures();
+
+  // `draws` holds GpuCullParams::maxDraws VkDrawIndexedIndirectCommands and
+  // `visibleInstances` as many u32s; instanceCount entries never overflow.
+  struct Bindings {
+    VkBuffer     instances;
+    VkBuffer     meshes;
+    VkBuffer     draws;
+    VkBuffer     countBuffer;
+    // bound as a storage buffer, so a multiple of
+    // minStorageBufferOffsetAlignment; indirectCountOffset<T>() is
+    VkDeviceSize countOffset{0};
+    VkBuffer     visibleInstances;
+    // min-reduction sampler over a reversed-Z pyramid, which needs the 1.2
+    // samplerFilterMinmax feature or VK_EXT_sampler_filter_minmax; must be
+    // valid even when occlusion is disabled
+    VkImageView depthPyramid;
+    VkSampler   pyramidSampler;
+  };
+
+  DescriptorSetLayout setLayout;
+  PipelineLayout      pipelineLayout;
+  VkPipeline          pipeline;
+
+  // `spirv` is Cull.comp compiled to SPIR-V
+  void create(VkDevice device, std::vector<u8>& spirv,
+              VkPipelineCache cache = VK_NULL_HANDLE);
+  void destroy(VkDevice device);
+
+  void writeDescriptorSet(VkDevice device, VkDescriptorSet set,
+                          Bindings const& bindings);
+
+  // resets the draw count, culls and makes the results visible to
+  // indirect draws and vertex shaders; record outside of a render pass
+  void record(CommandBuffer& cmd, VkDescriptorSet set,
+              Bindings const& bindings, GpuCullParams const& params);
+  // `maxDrawCount` is at most GpuCullParams::maxDraws
+  void draw(CommandBuffer& cmd, Bindings const& bindings, u32 maxDrawCount);
+};
+} // namespace ezvk
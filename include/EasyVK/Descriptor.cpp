@@ -61,6 +61,166 @@ void DescriptorPool::freeSet(VkDevice device, VkDescriptorSet set) {
   vkFreeDescriptorSets(device, descPool, 1, &set);
 }
 
+/*
+  DescriptorAllocator
+ */
+
+std::vector<DescriptorAllocator::PoolRatio>
+DescriptorAllocator::defaultRatios() {
+  return {
+      {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.f},
+      {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.f},
+      {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.f},
+      {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.f},
+      {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.f},
+      {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1.f},
+      {VK_DESCRIPTOR_TYPE_SAMPLER, 0.5f},
+  };
+}
+
+void DescriptorAllocator::create(VkDevice device, u32 initialSets,
+                                 std::vector<PoolRatio>      ratios,
+                                 VkDescriptorPoolCreateFlags flags) {
+  assert(initialSets > 0);
+  m_ratios      = std::move(ratios);
+  m_flags       = flags;
+  m_setsPerPool = std::min(initialSets, MAX_SETS_PER_POOL);
+  m_current     = takePool(device);
+}
+
+void DescriptorAllocator::destroy(VkDevice device) {
+  reset(device);
+  for (auto& pool : m_readyPools) {
+    pool.destroy(device);
+  }
+  m_readyPools.clear();
+  if (m_current.has_value()) {
+    m_current->destroy(device);
+    m_current.reset();
+  }
+}
+
+void DescriptorAllocator::reset(VkDevice device) {
+  if (m_current.has_value()) {
+    vkResetDescriptorPool(device, m_current->descPool, 0);
+  }
+  for (auto& pool : m_fullPools) {
+    vkResetDescriptorPool(device, pool.descPool, 0);
+    m_readyPools.push_back(pool);
+  }
+  m_fullPools.clear();
+}
+
+std::optional<DescriptorPool> DescriptorAllocator::takePool(VkDevice device) {
+  if (!m_readyPools.empty()) {
+    DescriptorPool pool = m_readyPools.back();
+    m_readyPools.pop_back();
+    return pool;
+  }
+  return createPool(device);
+}
+
+std::optional<DescriptorPool>
+DescriptorAllocator::createPool(VkDevice device) {
+  std::vector<VkDescriptorPoolSize> poolSizes;
+  poolSizes.reserve(m_ratios.size());
+  for (auto const& ratio : m_ratios) {
+    u32 count = std::max(1u, u32(ratio.ratio * float(m_setsPerPool)));
+    poolSizes.push_back({ratio.type, count});
+  }
+  DescriptorPool pool;
+  auto result = pool.create(device, m_flags, m_setsPerPool, poolSizes);
+  if (result != VK_SUCCESS) {
+    return std::nullopt;
+  }
+
+  // the next pool grows, so a busy frame settles on a few large pools
+  m_setsPerPool =
+      std::min(m_setsPerPool + m_setsPerPool / 2, MAX_SETS_PER_POOL);
+  return pool;
+}
+
+void DescriptorAllocator::usePool(DescriptorPool pool) {
+  if (m_current.has_value()) {
+    m_fullPools.push_back(*m_current);
+  }
+  m_current = pool;
+}
+
+// Raises the ratio of every type in `needs` to at least one set's worth;
+// false if none changed, so a new pool would fail the same way.
+bool DescriptorAllocator::growRatios(
+    std::span<const VkDescriptorPoolSize> needs) {
+  bool grown = false;
+  for (auto const& need : needs) {
+    u32 total = 0;
+    for (auto const& other : needs) {
+      if (other.type == need.type) {
+        total += other.descriptorCount;
+      }
+    }
+    auto it = std::find_if(m_ratios.begin(), m_ratios.end(),
+                           [&](auto const& r) { return r.type == need.type; });
+    if (it == m_ratios.end()) {
+      m_ratios.push_back({need.type, float(total)});
+      grown = true;
+    } else if (it->ratio < float(total)) {
+      it->ratio = float(total);
+      grown     = true;
+    }
+  }
+  return grown;
+}
+
+VkResult DescriptorAllocator::tryAllocate(VkDevice              device,
+                                          VkDescriptorSetLayout setLayout,
+                                          const void*           pNext,
+                                          VkDescriptorSet*      pSet) {
+  if (!m_current.has_value()) {
+    return VK_ERROR_OUT_OF_POOL_MEMORY;
+  }
+  VkDescriptorSetAllocateInfo AI{
+      .sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+      .pNext              = pNext,
+      .descriptorPool     = m_current->descPool,
+      .descriptorSetCount = 1,
+      .pSetLayouts        = &setLayout,
+  };
+  return vkAllocateDescriptorSets(device, &AI, pSet);
+}
+
+static bool poolFull(VkResult result) {
+  return result == VK_ERROR_OUT_OF_POOL_MEMORY ||
+         result == VK_ERROR_FRAGMENTED_POOL;
+}
+
+VkDescriptorSet
+DescriptorAllocator::allocate(VkDevice device, VkDescriptorSetLayout setLayout,
+                              std::span<const VkDescriptorPoolSize> needs,
+                              const void*                           pNext) {
+  VkDescriptorSet set;
+  bool            reused = false;
+  auto            result = tryAllocate(device, setLayout, pNext, &set);
+  if (poolFull(result)) {
+    reused = !m_readyPools.empty();
+    if (auto pool = takePool(device); pool.has_value()) {
+      usePool(*pool);
+      result = tryAllocate(device, setLayout, pNext, &set);
+    }
+  }
+  // An empty pool failing means the ratios it was made from do not cover
+  // the layout. Grow them, and retry with a new pool if they grew or the
+  // pool was a recycled one, which may predate earlier growth.
+  bool grown = poolFull(result) && growRatios(needs);
+  if (poolFull(result) && (grown || reused)) {
+    if (auto pool = createPool(device); pool.has_value()) {
+      usePool(*pool);
+      result = tryAllocate(device, setLayout, pNext, &set);
+    }
+  }
+  return result == VK_SUCCESS ? set : VK_NULL_HANDLE;
+}
+
 VkResult DescriptorSetLayout::create(VkDevice device, u32 bindingCount,
                                      VkDescriptorSetLayoutBinding* pBindings) {
   VkDescriptorSetLayoutCreateInfo CI{
@@ -101,4 +261,85 @@ WriteDescriptorSet::add(VkDescriptorSet dstSet, uint32_t dstBinding,
   writeSets.push_back(writeDS);
   return *this;
 }
+
+/*
+  DescriptorUpdateTemplate
+ */
+
+u32 DescriptorUpdateTemplate::descriptorSize(VkDescriptorType type) {
+  switch (type) {
+  case VK_DESCRIPTOR_TYPE_SAMPLER:
+  case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+  case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+  case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+  case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+    return sizeof(VkDescriptorImageInfo);
+  case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+  case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+    return sizeof(VkBufferView);
+  case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+  case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+  case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+  case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+    return sizeof(VkDescriptorBufferInfo);
+  default:
+    return 0;
+  }
+}
+
+VkResult DescriptorUpdateTemplate::create(
+    VkDevice device, VkDescriptorSetLayout setLayout,
+    std::span<const VkDescriptorUpdateTemplateEntry> entries, u32 dataSize) {
+  this->dataSize = dataSize;
+  VkDescriptorUpdateTemplateCreateInfo CI{
+      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO,
+      .pNext = nullptr,
+      .flags = 0,
+      .descriptorUpdateEntryCount = u32(entries.size()),
+      .pDescriptorUpdateEntries   = entries.data(),
+      .templateType        = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET,
+      .descriptorSetLayout = setLayout,
+      // the rest only apply to push descriptor templates
+      .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+      .pipelineLayout    = VK_NULL_HANDLE,
+      .set               = 0,
+  };
+  return vkCreateDescriptorUpdateTemplate(device, &CI, nullptr,
+                                          &updateTemplate);
+}
+
+VkResult DescriptorUpdateTemplate::create(
+    VkDevice device, VkDescriptorSetLayout setLayout,
+    DescriptorSetLayoutBindingList const& bindings) {
+  std::vector<VkDescriptorSetLayoutBinding> sorted = bindings.bindings;
+  std::sort(sorted.begin(), sorted.end(), [](auto const& lhs, auto const& rhs) {
+    return lhs.binding < rhs.binding;
+  });
+
+  std::vector<VkDescriptorUpdateTemplateEntry> entries;
+  size_t                                       offset = 0;
+  for (auto const& binding : sorted) {
+    u32 size = descriptorSize(binding.descriptorType);
+    if (size == 0) {
+      updateTemplate = VK_NULL_HANDLE;
+      dataSize       = 0;
+      return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+    // every info struct is 8-byte aligned, so no padding between them
+    entries.push_back({
+        .dstBinding      = binding.binding,
+        .dstArrayElement = 0,
+        .descriptorCount = binding.descriptorCount,
+        .descriptorType  = binding.descriptorType,
+        .offset          = offset,
+        .stride          = size,
+    });
+    offset += size_t(size) * binding.descriptorCount;
+  }
+  return create(device, setLayout, entries, u32(offset));
+}
+
+void DescriptorUpdateTemplate::destroy(VkDevice device) {
+  vkDestroyDescriptorUpdateTemplate(device, updateTemplate, nullptr);
+}
 } // namespace ezvk
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include <initializer_list>
 #include <span>
+#include <type_traits>
 namespace ezvk {
 
 struct DescriptorPoolSizeList {
@@ -46,6 +47,67 @@ struct DescriptorPool {
                 VkDescriptorSetLayout* pSetLayout);
   void freeSets(VkDevice device, std::vector<VkDescriptorSet>& sets);
 };
+
+// Allocates descriptor sets from a chain of pools. An exhausted or fragmented
+// pool is set aside and the next one, 1.5x larger up to MAX_SETS_PER_POOL, is
+// sized from the per-set ratios. If a layout does not fit even a fresh pool,
+// the ratios grow to cover the descriptors it needs, when those are passed
+// to allocate(). Sets are never freed one by one: reset() recycles every pool
+// at once, typically at the start of the frame that owns this allocator. Not
+// thread safe; create one per thread and frame in flight.
+class DescriptorAllocator {
+public:
+  static constexpr u32 MAX_SETS_PER_POOL = 4096;
+
+  // descriptors of `type` to reserve per set
+  struct PoolRatio {
+    VkDescriptorType type;
+    float            ratio;
+  };
+  static std::vector<PoolRatio> defaultRatios();
+
+  // `flags` apply to every pool, e.g. UPDATE_AFTER_BIND
+  void create(VkDevice device, u32 initialSets = 64,
+              std::vector<PoolRatio>      ratios = defaultRatios(),
+              VkDescriptorPoolCreateFlags flags  = 0);
+  void destroy(VkDevice device);
+
+  // sets allocated so far become invalid
+  void reset(VkDevice device);
+
+  // `pNext` is chained into VkDescriptorSetAllocateInfo, e.g. for variable
+  // descriptor counts. `needs` lists the descriptors one set of `setLayout`
+  // takes, by type, and lets the pools adapt to layouts the ratios do not
+  // cover. Returns VK_NULL_HANDLE if the set could not be allocated, e.g.
+  // without `needs` for such a layout; inline uniform blocks are never
+  // covered.
+  [[nodiscard]] VkDescriptorSet
+  allocate(VkDevice device, VkDescriptorSetLayout setLayout,
+           std::span<const VkDescriptorPoolSize> needs,
+           const void*                           pNext = nullptr);
+  [[nodiscard]] VkDescriptorSet allocate(VkDevice              device,
+                                         VkDescriptorSetLayout setLayout,
+                                         const void* pNext = nullptr) {
+    return allocate(device, setLayout, {}, pNext);
+  }
+
+private:
+  std::optional<DescriptorPool> takePool(VkDevice device);
+  std::optional<DescriptorPool> createPool(VkDevice device);
+  // makes `pool` current, setting the previous one aside as full
+  void     usePool(DescriptorPool pool);
+  bool     growRatios(std::span<const VkDescriptorPoolSize> needs);
+  VkResult tryAllocate(VkDevice device, VkDescriptorSetLayout setLayout,
+                       const void* pNext, VkDescriptorSet* pSet);
+
+  std::vector<PoolRatio>        m_ratios;
+  VkDescriptorPoolCreateFlags   m_flags;
+  u32                           m_setsPerPool;
+  std::vector<DescriptorPool>   m_readyPools;
+  std::vector<DescriptorPool>   m_fullPools;
+  std::optional<DescriptorPool> m_current;
+};
+
 struct DescriptorSetLayoutBindingList {
   std::vector<VkDescriptorSetLayoutBinding> bindings;
 
@@ -110,4 +172,59 @@ struct DescriptorSetLayout {
   EZVK_ADDRESS_OP(VkDescriptorSetLayout, setLayout);
 };
 
+// Writes a whole set from one packed struct with
+// vkUpdateDescriptorSetWithTemplate, instead of building a
+// WriteDescriptorSet on every update.
+//
+// The binding-list overload packs the descriptors densely in binding order,
+// each as a VkDescriptorImageInfo, VkDescriptorBufferInfo or VkBufferView
+// depending on its type. A struct declaring those members in the same order
+// matches that layout; only its size is checked, so getting the order right
+// is up to the caller. Bindings of other types, such as inline uniform
+// blocks or acceleration structures, fail with VK_ERROR_FEATURE_NOT_PRESENT.
+//
+//   struct MaterialDescriptors {
+//     VkDescriptorBufferInfo params;      // binding 0, uniform buffer
+//     VkDescriptorImageInfo  maps[4];     // binding 1, 4 image samplers
+//   };
+//   tmpl.create<MaterialDescriptors>(device, setLayout, bindings);
+struct DescriptorUpdateTemplate {
+  VkDescriptorUpdateTemplate updateTemplate;
+  u32                        dataSize;
+
+  // entry offsets and strides are into the data passed to update()
+  VkResult create(VkDevice device, VkDescriptorSetLayout setLayout,
+                  std::span<const VkDescriptorUpdateTemplateEntry> entries,
+                  u32 dataSize);
+  VkResult create(VkDevice device, VkDescriptorSetLayout setLayout,
+                  DescriptorSetLayoutBindingList const& bindings);
+  template <typename Data>
+  VkResult create(VkDevice device, VkDescriptorSetLayout setLayout,
+                  DescriptorSetLayoutBindingList const& bindings) {
+    auto result = create(device, setLayout, bindings);
+    assert((result != VK_SUCCESS || dataSize == sizeof(Data)) &&
+           "struct size does not match the binding list");
+    return result;
+  }
+
+  void destroy(VkDevice device);
+
+  void update(VkDevice device, VkDescriptorSet set, const void* pData) const {
+    vkUpdateDescriptorSetWithTemplate(device, set, updateTemplate, pData);
+  }
+  // pointers go to the overload above instead of having their own bytes
+  // passed as the data
+  template <typename Data>
+    requires(!std::is_pointer_v<Data> && !std::is_null_pointer_v<Data>)
+  void update(VkDevice device, VkDescriptorSet set, Data const& data) const {
+    assert(sizeof(Data) == dataSize);
+    update(device, set, static_cast<const void*>(&data));
+  }
+
+  // size of one descriptor of `type` in the packed data, 0 if unsupported
+  static u32 descriptorSize(VkDescriptorType type);
+
+  EZVK_CONVERT_OP(VkDescriptorUpdateTemplate, updateTemplate);
+};
+
 } // namespace ezvk
\ No newline at end of file
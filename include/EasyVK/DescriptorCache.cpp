@@ -0,0 +1,356 @@
+#include "DescriptorCache.hpp"
+
+#include <cstring>
+
+namespace ezvk {
+using detail::handleBits;
+
+size_t detail::CacheKeyHash::operator()(CacheKey const& key) const {
+  u64 hash = 0xcbf29ce484222325ull;
+  for (u64 word : key) {
+    hash ^= word + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+  }
+  return size_t(hash);
+}
+
+void DescriptorSetCache::create(
+    VkDevice device, u32 capacity, u32 framesInFlight,
+    std::vector<DescriptorAllocator::PoolRatio> ratios) {
+  assert(capacity > 0);
+  m_capacity       = capacity;
+  m_framesInFlight = framesInFlight;
+  m_frame          = 0;
+  m_stats          = {};
+  m_allocator.create(device, std::min(capacity, 256u), std::move(ratios));
+}
+
+void DescriptorSetCache::destroy(VkDevice device) {
+  m_lookup.clear();
+  m_entries.clear();
+  m_retired.clear();
+  m_freeSets.clear();
+  // the sets go with the pools
+  m_allocator.destroy(device);
+}
+
+void DescriptorSetCache::beginFrame(u64 frameIndex) {
+  m_frame = frameIndex;
+  std::erase_if(m_retired, [this](Retired const& retired) {
+    if (retired.frameIndex + m_framesInFlight > m_frame) {
+      return false;
+    }
+    m_freeSets[retired.setLayout].push_back(retired.set);
+    return true;
+  });
+}
+
+void DescriptorSetCache::invalidate() {
+  for (auto const& entry : m_entries) {
+    m_retired.push_back({entry.setLayout, entry.set, m_frame});
+  }
+  m_lookup.clear();
+  m_entries.clear();
+}
+
+// Descriptors written through pNext instead of the info arrays. Other
+// chained structs would not be part of the key, so they are rejected.
+static void appendPayload(detail::CacheKey&           key,
+                          VkWriteDescriptorSet const& write) {
+  for (auto const* next = static_cast<VkBaseInStructure const*>(write.pNext);
+       next != nullptr; next = next->pNext) {
+    switch (next->sType) {
+    case VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET_INLINE_UNIFORM_BLOCK_EXT: {
+      auto const* block = reinterpret_cast<
+          VkWriteDescriptorSetInlineUniformBlockEXT const*>(next);
+      auto const* bytes = static_cast<const u8*>(block->pData);
+      key.push_back(block->dataSize);
+      for (u32 offset = 0; offset < block->dataSize; offset += 8) {
+        u64 word = 0;
+        memcpy(&word, bytes + offset, std::min(8u, block->dataSize - offset));
+        key.push_back(word);
+      }
+      break;
+    }
+    case VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET_ACCELERATION_STRUCTURE_KHR: {
+      auto const* structures = reinterpret_cast<
+          VkWriteDescriptorSetAccelerationStructureKHR const*>(next);
+      for (u32 i = 0; i < structures->accelerationStructureCount; ++i) {
+        key.push_back(handleBits(structures->pAccelerationStructures[i]));
+      }
+      break;
+    }
+    default:
+      assert(false && "pNext struct not covered by the cache key");
+      break;
+    }
+  }
+}
+
+void DescriptorSetCache::buildKey(Key& key, VkDescriptorSetLayout setLayout,
+                                  WriteDescriptorSet const& writes) {
+  key.clear();
+  key.push_back(handleBits(setLayout));
+  for (auto const& write : writes.writeSets) {
+    key.push_back(u64(write.dstBinding) << 32 | write.dstArrayElement);
+    key.push_back(u64(write.descriptorType) << 32 | write.descriptorCount);
+    for (u32 i = 0; i < write.descriptorCount; ++i) {
+      if (write.pImageInfo != nullptr) {
+        auto const& info = write.pImageInfo[i];
+        key.push_back(handleBits(info.sampler));
+        key.push_back(handleBits(info.imageView));
+        key.push_back(u64(info.imageLayout));
+      } else if (write.pBufferInfo != nullptr) {
+        auto const& info = write.pBufferInfo[i];
+        key.push_back(handleBits(info.buffer));
+        key.push_back(info.offset);
+        key.push_back(info.range);
+      } else if (write.pTexelBufferView != nullptr) {
+        key.push_back(handleBits(write.pTexelBufferView[i]));
+      }
+    }
+    appendPayload(key, write);
+  }
+}
+
+VkDescriptorSet DescriptorSetCache::get(VkDevice              device,
+                                        VkDescriptorSetLayout setLayout,
+                                        WriteDescriptorSet const& writes) {
+  buildKey(m_scratchKey, setLayout, writes);
+  if (auto it = m_lookup.find(m_scratchKey); it != m_lookup.end()) {
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    it->second->lastUsed = m_frame;
+    m_stats.hits += 1;
+    return it->second->set;
+  }
+
+  m_stats.misses += 1;
+  if (m_entries.size() >= m_capacity) {
+    // over capacity when every entry is still in flight, until they age out
+    evictOne();
+  }
+  VkDescriptorSet set = takeSet(device, setLayout, writes);
+  if (set == VK_NULL_HANDLE) {
+    return VK_NULL_HANDLE;
+  }
+
+  auto copies = writes.writeSets;
+  for (auto& write : copies) {
+    write.dstSet = set;
+  }
+  vkUpdateDescriptorSets(device, u32(copies.size()), copies.data(), 0,
+                         nullptr);
+
+  m_entries.push_front({m_scratchKey, setLayout, set, m_frame});
+  m_lookup.emplace(m_scratchKey, m_entries.begin());
+  return set;
+}
+
+bool DescriptorSetCache::evictOne() {
+  auto& last = m_entries.back();
+  if (last.lastUsed + m_framesInFlight > m_frame) {
+    return false;
+  }
+  m_freeSets[last.setLayout].push_back(last.set);
+  m_lookup.erase(last.key);
+  m_entries.pop_back();
+  m_stats.evictions += 1;
+  return true;
+}
+
+VkDescriptorSet
+DescriptorSetCache::takeSet(VkDevice device, VkDescriptorSetLayout setLayout,
+                            WriteDescriptorSet const& writes) {
+  if (auto it = m_freeSets.find(setLayout);
+      it != m_freeSets.end() && !it->second.empty()) {
+    VkDescriptorSet set = it->second.back();
+    it->second.pop_back();
+    return set;
+  }
+  // the writes stand in for the layout's bindings, so pools can grow to
+  // layouts the ratios do not cover
+  m_scratchNeeds.clear();
+  for (auto const& write : writes.writeSets) {
+    m_scratchNeeds.push_back({write.descriptorType, write.descriptorCount});
+  }
+  return m_allocator.allocate(device, setLayout, m_scratchNeeds);
+}
+
+/*
+  LayoutCache
+ */
+
+CachedSetLayout::~CachedSetLayout() {
+  vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
+}
+
+CachedPipelineLayout::~CachedPipelineLayout() {
+  vkDestroyPipelineLayout(device, layout, nullptr);
+}
+
+void LayoutCache::create(VkDevice device) {
+  std::lock_guard lock(m_mutex);
+  m_device = device;
+  m_setLayouts.clear();
+  m_pipelineLayouts.clear();
+}
+
+void LayoutCache::destroy() {
+  std::lock_guard lock(m_mutex);
+  // pipeline layouts first, they hold references to set layouts
+  m_pipelineLayouts.clear();
+  m_setLayouts.clear();
+}
+
+template <typename Value, typename Factory>
+std::shared_ptr<Value> LayoutCache::findOrCreate(Table<Value>&      table,
+                                                 detail::CacheKey&& key,
+                                                 Factory&&          factory) {
+  {
+    std::shared_lock lock(m_mutex);
+    if (auto it = table.find(key); it != table.end()) {
+      return it->second;
+    }
+  }
+
+  std::lock_guard lock(m_mutex);
+  // another thread may have created it between the two locks
+  if (auto it = table.find(key); it != table.end()) {
+    return it->second;
+  }
+  std::shared_ptr<Value> value = factory();
+  table.emplace(std::move(key), value);
+  return value;
+}
+
+LayoutCache::SetLayoutHandle LayoutCache::getSetLayout(
+    DescriptorSetLayoutBindingList const&     bindings,
+    VkDescriptorSetLayoutCreateFlags          flags,
+    std::span<const VkDescriptorBindingFlags> bindingFlags) {
+  assert(bindingFlags.empty() ||
+         bindingFlags.size() == bindings.bindings.size());
+  std::vector<u32> order(bindings.bindings.size());
+  for (u32 i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), [&](u32 lhs, u32 rhs) {
+    return bindings.bindings[lhs].binding < bindings.bindings[rhs].binding;
+  });
+
+  std::vector<VkDescriptorSetLayoutBinding> sorted;
+  std::vector<VkDescriptorBindingFlags>     sortedFlags;
+  detail::CacheKey                          key;
+  key.push_back(flags);
+  for (u32 index : order) {
+    auto const& binding = bindings.bindings[index];
+    sorted.push_back(binding);
+    key.push_back(u64(binding.binding) << 32 | binding.descriptorType);
+    key.push_back(u64(binding.descriptorCount) << 32 | binding.stageFlags);
+    if (!bindingFlags.empty()) {
+      sortedFlags.push_back(bindingFlags[index]);
+      key.push_back(bindingFlags[index]);
+    }
+    if (binding.pImmutableSamplers != nullptr) {
+      for (u32 i = 0; i < binding.descriptorCount; ++i) {
+        key.push_back(handleBits(binding.pImmutableSamplers[i]));
+      }
+    }
+  }
+
+  return findOrCreate(m_setLayouts, std::move(key), [&] {
+    VkDescriptorSetLayoutBindingFlagsCreateInfo flagsInfo{
+        .sType =
+            VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+        .pNext         = nullptr,
+        .bindingCount  = u32(sortedFlags.size()),
+        .pBindingFlags = sortedFlags.data(),
+    };
+    VkDescriptorSetLayoutCreateInfo CI{
+        .sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .pNext        = sortedFlags.empty() ? nullptr : &flagsInfo,
+        .flags        = flags,
+        .bindingCount = u32(sorted.size()),
+        .pBindings    = sorted.data(),
+    };
+    VkDescriptorSetLayout setLayout;
+    auto result =
+        vkCreateDescriptorSetLayout(m_device, &CI, nullptr, &setLayout);
+    assert(result == VK_SUCCESS);
+    return std::make_shared<CachedSetLayout>(m_device, setLayout);
+  });
+}
+
+LayoutCache::PipelineLayoutHandle LayoutCache::getPipelineLayout(
+    std::span<const SetLayoutHandle>     setLayouts,
+    std::span<const VkPushConstantRange> pushConstants) {
+  std::vector<VkPushConstantRange> ranges(pushConstants.begin(),
+                                          pushConstants.end());
+  std::sort(ranges.begin(), ranges.end(), [](auto const& lhs, auto const& rhs) {
+    if (lhs.offset != rhs.offset) {
+      return lhs.offset < rhs.offset;
+    }
+    if (lhs.size != rhs.size) {
+      return lhs.size < rhs.size;
+    }
+    return lhs.stageFlags < rhs.stageFlags;
+  });
+
+  // set layouts are deduplicated, so their handles identify their contents
+  detail::CacheKey key;
+  key.push_back(setLayouts.size());
+  for (auto const& setLayout : setLayouts) {
+    key.push_back(handleBits(setLayout->setLayout));
+  }
+  for (auto const& range : ranges) {
+    key.push_back(u64(range.offset) << 32 | range.size);
+    key.push_back(range.stageFlags);
+  }
+
+  return findOrCreate(m_pipelineLayouts, std::move(key), [&] {
+    std::vector<VkDescriptorSetLayout> handles;
+    for (auto const& setLayout : setLayouts) {
+      handles.push_back(setLayout->setLayout);
+    }
+    VkPipelineLayoutCreateInfo CI{
+        .sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .pNext                  = nullptr,
+        .flags                  = 0,
+        .setLayoutCount         = u32(handles.size()),
+        .pSetLayouts            = handles.data(),
+        .pushConstantRangeCount = u32(ranges.size()),
+        .pPushConstantRanges    = ranges.data(),
+    };
+    VkPipelineLayout layout;
+    auto result = vkCreatePipelineLayout(m_device, &CI, nullptr, &layout);
+    assert(result == VK_SUCCESS);
+    return std::make_shared<CachedPipelineLayout>(
+        m_device, layout,
+        std::vector<SetLayoutHandle>(setLayouts.begin(), setLayouts.end()));
+  });
+}
+
+// with m_mutex held exclusively, so the table's reference can only be the
+// last one if no handle exists outside
+template <typename Value>
+u32 LayoutCache::collectTable(Table<Value>& table) {
+  return u32(std::erase_if(table, [](auto const& entry) {
+    return entry.second.use_count() == 1;
+  }));
+}
+
+u32 LayoutCache::collect() {
+  std::lock_guard lock(m_mutex);
+  // pipeline layouts first, dropping them may release set layouts
+  u32 dropped = collectTable(m_pipelineLayouts);
+  return dropped + collectTable(m_setLayouts);
+}
+
+u32 LayoutCache::setLayoutCount() const {
+  std::shared_lock lock(m_mutex);
+  return u32(m_setLayouts.size());
+}
+
+u32 LayoutCache::pipelineLayoutCount() const {
+  std::shared_lock lock(m_mutex);
+  return u32(m_pipelineLayouts.size());
+}
+} // namespace ezvk
@@ -0,0 +1,194 @@
+#pragma once
+#include "common.hpp"
+
+#include "Descriptor.hpp"
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <span>
+#include <type_traits>
+#include <unordered_map>
+
+namespace ezvk {
+namespace detail {
+// cache keys are flattened into 64-bit words
+using CacheKey = std::vector<u64>;
+struct CacheKeyHash {
+  size_t operator()(CacheKey const& key) const;
+};
+
+template <typename Handle>
+u64 handleBits(Handle handle) {
+  // non-dispatchable handles are pointers on 64-bit targets only
+  if constexpr (std::is_pointer_v<Handle>) {
+    return u64(reinterpret_cast<uintptr_t>(handle));
+  } else {
+    return u64(handle);
+  }
+}
+} // namespace detail
+
+// Returns an existing descriptor set when a layout has already been written
+// with the same descriptors, so steady-state frames skip
+// vkUpdateDescriptorSets. The key covers the layout and every write's
+// binding, type and buffer/image/texel-view infos, plus inline uniform
+// block data and acceleration structures chained through pNext; dstSet is
+// ignored. Other pNext structs are not supported.
+//
+// Sets used within the last `framesInFlight` frames are never rewritten.
+// Past `capacity` entries the least recently used one is evicted and its set
+// reused for the next miss with the same layout. Not thread safe.
+class DescriptorSetCache {
+public:
+  struct Stats {
+    u64 hits{0};
+    u64 misses{0};
+    u64 evictions{0};
+  };
+
+  void create(VkDevice device, u32 capacity, u32 framesInFlight,
+              std::vector<DescriptorAllocator::PoolRatio> ratios =
+                  DescriptorAllocator::defaultRatios());
+  void destroy(VkDevice device);
+
+  // call once per frame, before get()
+  void beginFrame(u64 frameIndex);
+  // Drops every entry, e.g. after resources they reference were destroyed.
+  // The sets are reused once the frames in flight are past them.
+  void invalidate();
+
+  // VK_NULL_HANDLE if no set of `setLayout` could be allocated
+  [[nodiscard]] VkDescriptorSet get(VkDevice              device,
+                                    VkDescriptorSetLayout setLayout,
+                                    WriteDescriptorSet const& writes);
+
+  Stats const& stats() const {
+    return m_stats;
+  }
+  u32 size() const {
+    return u32(m_entries.size());
+  }
+
+private:
+  using Key = detail::CacheKey;
+  struct Entry {
+    Key                   key;
+    VkDescriptorSetLayout setLayout;
+    VkDescriptorSet       set;
+    u64                   lastUsed;
+  };
+  struct Retired {
+    VkDescriptorSetLayout setLayout;
+    VkDescriptorSet       set;
+    u64                   frameIndex;
+  };
+
+  static void buildKey(Key& key, VkDescriptorSetLayout setLayout,
+                       WriteDescriptorSet const& writes);
+  bool        evictOne();
+  VkDescriptorSet takeSet(VkDevice device, VkDescriptorSetLayout setLayout,
+                          WriteDescriptorSet const& writes);
+
+  DescriptorAllocator               m_allocator;
+  u32                               m_capacity;
+  u32                               m_framesInFlight;
+  u64                               m_frame{0};
+  Stats                             m_stats;
+  Key                               m_scratchKey;
+  std::vector<VkDescriptorPoolSize> m_scratchNeeds;
+
+  // most recently used first
+  std::list<Entry> m_entries;
+  std::unordered_map<Key, std::list<Entry>::iterator, detail::CacheKeyHash>
+                       m_lookup;
+  std::vector<Retired> m_retired;
+  std::unordered_map<VkDescriptorSetLayout, std::vector<VkDescriptorSet>>
+      m_freeSets;
+};
+
+// Owns a layout for as long as a handle to it exists; the Vulkan object is
+// destroyed with the last reference.
+struct CachedSetLayout {
+  VkDevice              device;
+  VkDescriptorSetLayout setLayout;
+
+  CachedSetLayout(VkDevice device, VkDescriptorSetLayout setLayout)
+      : device(device), setLayout(setLayout) {}
+  CachedSetLayout(CachedSetLayout const&)            = delete;
+  CachedSetLayout& operator=(CachedSetLayout const&) = delete;
+  ~CachedSetLayout();
+
+  EZVK_CONVERT_OP(VkDescriptorSetLayout, setLayout);
+};
+
+struct CachedPipelineLayout {
+  VkDevice         device;
+  VkPipelineLayout layout;
+  // keeps the set layouts alive as long as the pipeline layout
+  std::vector<std::shared_ptr<CachedSetLayout>> setLayouts;
+
+  CachedPipelineLayout(VkDevice device, VkPipelineLayout layout,
+                       std::vector<std::shared_ptr<CachedSetLayout>> sets)
+      : device(device), layout(layout), setLayouts(std::move(sets)) {}
+  CachedPipelineLayout(CachedPipelineLayout const&)            = delete;
+  CachedPipelineLayout& operator=(CachedPipelineLayout const&) = delete;
+  ~CachedPipelineLayout();
+
+  EZVK_CONVERT_OP(VkPipelineLayout, layout);
+};
+
+// Deduplicates descriptor set layouts and pipeline layouts by content, so
+// identical binding lists share one VkDescriptorSetLayout and pipelines
+// built from them stay layout compatible. Bindings and push-constant ranges
+// are sorted before hashing, so declaration order does not matter.
+//
+// Thread safe. Lookups of existing layouts take a shared lock, so they run
+// concurrently with each other; creating a layout or collect() takes it
+// exclusively.
+class LayoutCache {
+public:
+  using SetLayoutHandle      = std::shared_ptr<CachedSetLayout>;
+  using PipelineLayoutHandle = std::shared_ptr<CachedPipelineLayout>;
+
+  void create(VkDevice device);
+  // handles still held elsewhere keep their layouts alive
+  void destroy();
+
+  // `bindingFlags`, if not empty, has one entry per binding in `bindings`
+  [[nodiscard]] SetLayoutHandle
+  getSetLayout(DescriptorSetLayoutBindingList const& bindings,
+               VkDescriptorSetLayoutCreateFlags      flags        = 0,
+               std::span<const VkDescriptorBindingFlags> bindingFlags = {});
+  [[nodiscard]] PipelineLayoutHandle
+  getPipelineLayout(std::span<const SetLayoutHandle>     setLayouts,
+                    std::span<const VkPushConstantRange> pushConstants = {});
+
+  // Drops the layouts no one else holds a handle to; returns how many.
+  // Call at a quiet point, e.g. after unloading a module.
+  u32 collect();
+
+  u32 setLayoutCount() const;
+  u32 pipelineLayoutCount() const;
+
+private:
+  template <typename Value>
+  using Table = std::unordered_map<detail::CacheKey, std::shared_ptr<Value>,
+                                   detail::CacheKeyHash>;
+  using SetLayoutTable      = Table<CachedSetLayout>;
+  using PipelineLayoutTable = Table<CachedPipelineLayout>;
+
+  template <typename Value, typename Factory>
+  std::shared_ptr<Value> findOrCreate(Table<Value>&      table,
+                                      detail::CacheKey&& key,
+                                      Factory&&          factory);
+  template <typename Value>
+  static u32 collectTable(Table<Value>& table);
+
+  VkDevice                  m_device;
+  mutable std::shared_mutex m_mutex;
+  SetLayoutTable            m_setLayouts;
+  PipelineLayoutTable       m_pipelineLayouts;
+};
+} // namespace ezvk
@@ -0,0 +1,168 @@
+#include "DrawQueue.hpp"
+
+#include <bit>
+#include <cstring>
+
+namespace ezvk {
+template <typename Handle>
+static u64 handleBits(Handle handle) {
+  return (u64)handle;
+}
+
+static bool sameState(DrawPacket const& a, DrawPacket const& b) {
+  return a.pipeline == b.pipeline && a.layout == b.layout &&
+         a.descriptorSet == b.descriptorSet &&
+         a.materialSet == b.materialSet && a.vertexBuffer == b.vertexBuffer &&
+         a.indexBuffer == b.indexBuffer && a.indexType == b.indexType;
+}
+
+void DrawQueue::clear() {
+  m_packets.clear();
+  m_keys.clear();
+  m_order.clear();
+  m_pipelineIds.clear();
+  m_setIds.clear();
+  m_materialIds.clear();
+  m_bufferIds.clear();
+  m_stats = {};
+}
+
+void DrawQueue::submit(DrawPacket const& packet) {
+  m_keys.push_back(makeKey(packet));
+  m_packets.push_back(packet);
+  m_stats.submitted++;
+}
+
+// ids are handed out in submission order and wrap when a field overflows;
+// that only weakens the grouping, emit() compares the real handles
+u64 DrawQueue::intern(std::unordered_map<u64, u64>& ids, u64 handle,
+                      u64 mask) {
+  auto [it, inserted] = ids.try_emplace(handle, u64(ids.size()) & mask);
+  return it->second;
+}
+
+u64 DrawQueue::makeKey(DrawPacket const& packet) {
+  u64 pipeline = intern(m_pipelineIds, handleBits(packet.pipeline), 0x3ff);
+  u64 set      = intern(m_setIds, handleBits(packet.descriptorSet), 0x3fff);
+  u64 material = intern(m_materialIds, handleBits(packet.materialSet), 0xfff);
+  u64 buffers  = intern(m_bufferIds,
+                        handleBits(packet.vertexBuffer) * 31 +
+                            handleBits(packet.indexBuffer),
+                        0xfff);
+  // positive floats keep their order when compared as integers
+  u64 depth = std::bit_cast<u32>(std::max(packet.depth, 0.0f)) >> 16;
+
+  return pipeline << 54 | set << 40 | material << 28 | buffers << 16 | depth;
+}
+
+void DrawQueue::sort() {
+  u32 count = u32(m_packets.size());
+  m_order.resize(count);
+  m_scratch.resize(count);
+  for (u32 i = 0; i < count; ++i) {
+    m_order[i] = i;
+  }
+  if (count < 2) {
+    return;
+  }
+
+  // LSD radix sort on 8-bit digits, passes where all keys share the same
+  // digit are skipped
+  for (u32 shift = 0; shift < 64; shift += 8) {
+    u32 histogram[256]{};
+    for (u64 key : m_keys) {
+      histogram[(key >> shift) & 0xff]++;
+    }
+    if (histogram[(m_keys[0] >> shift) & 0xff] == count) {
+      continue;
+    }
+    u32 offset = 0;
+    for (u32& bucket : histogram) {
+      u32 size = bucket;
+      bucket   = offset;
+      offset += size;
+    }
+    for (u32 index : m_order) {
+      m_scratch[histogram[(m_keys[index] >> shift) & 0xff]++] = index;
+    }
+    m_order.swap(m_scratch);
+  }
+}
+
+u32 DrawQueue::collectRun(
+    u32 first, std::vector<VkDrawIndexedIndirectCommand>& run) const {
+  u32 const         count  = u32(m_order.size());
+  DrawPacket const& packet = m_packets[m_order[first]];
+
+  run.clear();
+  u32 end = first;
+  for (; end < count && sameState(packet, m_packets[m_order[end]]); ++end) {
+    DrawPacket const& next = m_packets[m_order[end]];
+    if (!run.empty()) {
+      auto& last = run.back();
+      if (last.indexCount == next.indexCount &&
+          last.firstIndex == next.firstIndex &&
+          last.vertexOffset == next.vertexOffset &&
+          last.firstInstance + last.instanceCount == next.firstInstance) {
+        last.instanceCount += next.instanceCount;
+        continue;
+      }
+    }
+    run.push_back({next.indexCount, next.instanceCount, next.firstIndex,
+                   next.vertexOffset, next.firstInstance});
+  }
+  return end;
+}
+
+void DrawQueue::emit(CommandBuffer& cmd, IndirectTarget* indirect) {
+  u32 const   count        = u32(m_order.size());
+  u32         indirectUsed = 0;
+  DrawPacket* bound        = nullptr;
+
+  for (u32 i = 0; i < count;) {
+    DrawPacket& packet = m_packets[m_order[i]];
+
+    if (!bound || bound->pipeline != packet.pipeline) {
+      cmd.bindPipelineGraphic(packet.pipeline);
+      m_stats.pipelineBinds++;
+    }
+    if (!bound || bound->layout != packet.layout ||
+        bound->descriptorSet != packet.descriptorSet ||
+        bound->materialSet != packet.materialSet) {
+      VkDescriptorSet sets[]{packet.descriptorSet, packet.materialSet};
+      cmd.bindDescriptorSetNoDynamic(VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                     packet.layout, 0,
+                                     packet.materialSet ? 2 : 1, sets);
+      m_stats.descriptorBinds++;
+    }
+    if (!bound || bound->vertexBuffer != packet.vertexBuffer) {
+      cmd.bindVertexBuffer(packet.vertexBuffer);
+    }
+    if (!bound || bound->indexBuffer != packet.indexBuffer ||
+        bound->indexType != packet.indexType) {
+      cmd.bindIndexBuffer(packet.indexBuffer, packet.indexType);
+    }
+    bound = &packet;
+
+    i = collectRun(i, m_run);
+
+    u32 runSize = u32(m_run.size());
+    if (indirect && runSize > 1 &&
+        indirectUsed + runSize <= indirect->capacity) {
+      std::memcpy(indirect->mapped + indirectUsed, m_run.data(),
+                  runSize * sizeof(VkDrawIndexedIndirectCommand));
+      cmd.drawIndexedIndirect(
+          indirect->buffer,
+          indirectUsed * sizeof(VkDrawIndexedIndirectCommand), runSize);
+      indirectUsed += runSize;
+      m_stats.drawCalls++;
+      continue;
+    }
+    for (auto const& draw : m_run) {
+      cmd.drawIndexed(draw.indexCount, draw.instanceCount, draw.firstIndex,
+                      u32(draw.vertexOffset), draw.firstInstance);
+    }
+    m_stats.drawCalls += runSize;
+  }
+}
+} // namespace ezvk
@@ -0,0 +1,85 @@
+#pragma once
+#include "common.hpp"
+
+#include "Command.hpp"
+
+#include <span>
+#include <unordered_map>
+
+namespace ezvk {
+struct DrawPacket {
+  VkPipeline       pipeline;
+  VkPipelineLayout layout;
+  VkDescriptorSet  descriptorSet;                // bound at set 0
+  VkDescriptorSet  materialSet{VK_NULL_HANDLE}; // bound at set 1 if not null
+  VkBuffer         vertexBuffer;
+  VkBuffer         indexBuffer;
+  VkIndexType      indexType{VK_INDEX_TYPE_UINT32};
+
+  u32   indexCount;
+  u32   firstIndex{0};
+  i32   vertexOffset{0};
+  u32   firstInstance{0};
+  u32   instanceCount{1};
+  float depth{0.0f}; // view distance, sorted front to back
+};
+
+// Collects DrawPackets for a frame, radix-sorts them on a 64-bit state key
+// and emits them with as few binds and draw calls as possible.
+class DrawQueue {
+public:
+  // Host-visible storage that runs of same-state draws are written to, so
+  // each run becomes one drawIndexedIndirect. Needs the multiDrawIndirect
+  // feature.
+  struct IndirectTarget {
+    VkBuffer                      buffer;
+    VkDrawIndexedIndirectCommand* mapped;
+    u32                           capacity;
+  };
+
+  struct Stats {
+    u32 submitted{0};
+    u32 drawCalls{0};
+    u32 pipelineBinds{0};
+    u32 descriptorBinds{0};
+  };
+
+  void clear();
+  void submit(DrawPacket const& packet);
+  void sort();
+  // call sort() first; `indirect` may be null to emit direct draws only
+  void emit(CommandBuffer& cmd, IndirectTarget* indirect = nullptr);
+
+  Stats const& stats() const {
+    return m_stats;
+  }
+  // submission indices in draw order, valid after sort()
+  std::span<const u32> order() const {
+    return m_order;
+  }
+  // Collapses the same-state packets starting at position `first` of
+  // order() into `run`, merging consecutive instances of the same geometry
+  // into one instanced draw. Returns the position after the run.
+  u32 collectRun(u32 first,
+                 std::vector<VkDrawIndexedIndirectCommand>& run) const;
+
+private:
+  // [63:54] pipeline [53:40] descriptor set [39:28] material
+  // [27:16] vertex/index buffers [15:0] depth
+  u64 makeKey(DrawPacket const& packet);
+  u64 intern(std::unordered_map<u64, u64>& ids, u64 handle, u64 mask);
+
+  std::vector<DrawPacket> m_packets;
+  std::vector<u64>        m_keys;
+  std::vector<u32>        m_order;
+  std::vector<u32>        m_scratch;
+
+  std::unordered_map<u64, u64> m_pipelineIds;
+  std::unordered_map<u64, u64> m_setIds;
+  std::unordered_map<u64, u64> m_materialIds;
+  std::unordered_map<u64, u64> m_bufferIds;
+
+  std::vector<VkDrawIndexedIndirectCommand> m_run;
+  Stats                                     m_stats;
+};
+} // namespace ezvk
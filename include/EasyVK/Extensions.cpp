@@ -0,0 +1,57 @@
+#include "Extensions.hpp"
+
+#include <cstddef>
+
+namespace ezvk {
+Features12& Features12::add(VkPhysicalDeviceVulkan12Features const& other) {
+  // every member after sType and pNext is a VkBool32
+  using Features         = VkPhysicalDeviceVulkan12Features;
+  constexpr size_t begin = offsetof(Features, samplerMirrorClampToEdge);
+  constexpr size_t end =
+      offsetof(Features, subgroupBroadcastDynamicId) + sizeof(VkBool32);
+  constexpr size_t count = (end - begin) / sizeof(VkBool32);
+
+  auto* dst = reinterpret_cast<VkBool32*>(reinterpret_cast<u8*>(&features) +
+                                          begin);
+  auto const* src = reinterpret_cast<VkBool32 const*>(
+      reinterpret_cast<u8 const*>(&other) + begin);
+  for (size_t i = 0; i < count; ++i) {
+    dst[i] = dst[i] | src[i];
+  }
+  return *this;
+}
+
+void DynamicRendering::require(vkb::PhysicalDeviceSelector& selector) {
+  VkPhysicalDeviceDynamicRenderingFeaturesKHR features{
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR,
+      .pNext = nullptr,
+      .dynamicRendering = VK_TRUE,
+  };
+  selector.add_required_extension(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME)
+      .add_required_extension_features(features);
+}
+
+void DynamicRendering::load(VkDevice device) {
+  fpBegin = reinterpret_cast<PFN_vkCmdBeginRenderingKHR>(
+      vkGetDeviceProcAddr(device, "vkCmdBeginRenderingKHR"));
+  fpEnd = reinterpret_cast<PFN_vkCmdEndRenderingKHR>(
+      vkGetDeviceProcAddr(device, "vkCmdEndRenderingKHR"));
+}
+
+void Synchronization2::require(vkb::PhysicalDeviceSelector& selector) {
+  VkPhysicalDeviceSynchronization2FeaturesKHR features{
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR,
+      .pNext = nullptr,
+      .synchronization2 = VK_TRUE,
+  };
+  selector.add_required_extension(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME)
+      .add_required_extension_features(features);
+}
+
+void Synchronization2::load(VkDevice device) {
+  fpQueueSubmit2 = reinterpret_cast<PFN_vkQueueSubmit2KHR>(
+      vkGetDeviceProcAddr(device, "vkQueueSubmit2KHR"));
+  fpCmdPipelineBarrier2 = reinterpret_cast<PFN_vkCmdPipelineBarrier2KHR>(
+      vkGetDeviceProcAddr(device, "vkCmdPipelineBarrier2KHR"));
+}
+} // namespace ezvk
@@ -0,0 +1,55 @@
+#pragma once
+#include "common.hpp"
+
+namespace ezvk {
+// The instance targets Vulkan 1.2, so features promoted to core in 1.3 are
+// reached through their KHR extensions. require() adds the extension and its
+// feature to the device selection; load() resolves the entry points once the
+// device exists.
+
+// Vulkan 1.2 core features. vk-bootstrap chains every struct passed to
+// set_required_features_12 as is, but the device create info may hold only
+// one VkPhysicalDeviceVulkan12Features, so the requirements of each part of
+// the library are merged here and required once:
+//
+//   Features12 features12;
+//   features12.add(TimelineSemaphore::requiredFeatures())
+//       .add(BindlessHeap::requiredFeatures());
+//   features12.require(selector);
+struct Features12 {
+  VkPhysicalDeviceVulkan12Features features{
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+      .pNext = nullptr,
+  };
+
+  // enables every feature enabled in `other`
+  Features12& add(VkPhysicalDeviceVulkan12Features const& other);
+  void        require(vkb::PhysicalDeviceSelector& selector) const {
+    selector.set_required_features_12(features);
+  }
+};
+
+// VK_KHR_dynamic_rendering
+struct DynamicRendering {
+  PFN_vkCmdBeginRenderingKHR fpBegin{nullptr};
+  PFN_vkCmdEndRenderingKHR   fpEnd{nullptr};
+
+  static void require(vkb::PhysicalDeviceSelector& selector);
+  void        load(VkDevice device);
+  bool        supported() const {
+    return fpBegin != nullptr && fpEnd != nullptr;
+  }
+};
+
+// VK_KHR_synchronization2
+struct Synchronization2 {
+  PFN_vkQueueSubmit2KHR        fpQueueSubmit2{nullptr};
+  PFN_vkCmdPipelineBarrier2KHR fpCmdPipelineBarrier2{nullptr};
+
+  static void require(vkb::PhysicalDeviceSelector& selector);
+  void        load(VkDevice device);
+  bool        supported() const {
+    return fpQueueSubmit2 != nullptr && fpCmdPipelineBarrier2 != nullptr;
+  }
+};
+} // namespace ezvk
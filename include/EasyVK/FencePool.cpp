@@ -0,0 +1,179 @@
+#include "FencePool.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+namespace ezvk {
+void FencePool::create(VkDevice device, u32 initialCount) {
+  m_device = device;
+  m_free.resize(initialCount);
+  for (auto& fence : m_free) {
+    fence.create(device, 0);
+  }
+}
+
+void FencePool::destroy() {
+  stopWatcher();
+  while (watchedCount() != 0) {
+    std::vector<VkFence> fences;
+    {
+      std::lock_guard lock{m_mutex};
+      for (auto& watched : m_watched) {
+        fences.push_back(watched.fence);
+      }
+    }
+    auto result = vkWaitForFences(m_device, u32(fences.size()),
+                                  fences.data(), VK_TRUE,
+                                  TimelineSemaphore::NO_TIMEOUT);
+    if (result != VK_SUCCESS) {
+      // e.g. VK_ERROR_DEVICE_LOST: the fences never signal, drop them
+      std::lock_guard lock{m_mutex};
+      for (auto& watched : m_watched) {
+        watched.fence.destroy(m_device);
+      }
+      m_watched.clear();
+      break;
+    }
+    poll();
+  }
+  for (auto& fence : m_free) {
+    fence.destroy(m_device);
+  }
+  m_free.clear();
+}
+
+Fence FencePool::acquire() {
+  {
+    std::lock_guard lock{m_mutex};
+    if (!m_free.empty()) {
+      Fence fence = m_free.back();
+      m_free.pop_back();
+      return fence;
+    }
+  }
+  Fence fence;
+  fence.create(m_device, 0);
+  return fence;
+}
+
+void FencePool::release(Fence fence) {
+  std::lock_guard lock{m_mutex};
+  recycle(fence);
+}
+
+void FencePool::recycle(Fence fence) {
+  if (std::find(m_waiting.begin(), m_waiting.end(), fence.fence) !=
+      m_waiting.end()) {
+    m_deferred.push_back(fence);
+    return;
+  }
+  if (vkGetFenceStatus(m_device, fence) == VK_SUCCESS) {
+    auto result = fence.reset(m_device);
+    assert(result == VK_SUCCESS);
+  }
+  m_free.push_back(fence);
+}
+
+void FencePool::watch(Fence fence, Callback onComplete) {
+  {
+    std::lock_guard lock{m_mutex};
+    m_watched.push_back({fence, std::move(onComplete)});
+  }
+  m_wakeup.notify_one();
+}
+
+u32 FencePool::poll() {
+  std::vector<Watched> completed;
+  {
+    std::lock_guard lock{m_mutex};
+    auto            it = std::stable_partition(
+        m_watched.begin(), m_watched.end(), [this](Watched& watched) {
+          return vkGetFenceStatus(m_device, watched.fence) != VK_SUCCESS;
+        });
+    std::move(it, m_watched.end(), std::back_inserter(completed));
+    m_watched.erase(it, m_watched.end());
+  }
+  if (completed.empty()) {
+    return 0;
+  }
+  // callbacks run unlocked so they can submit and watch again
+  for (auto& watched : completed) {
+    if (watched.onComplete) {
+      watched.onComplete();
+    }
+  }
+  std::lock_guard lock{m_mutex};
+  for (auto& watched : completed) {
+    recycle(watched.fence);
+  }
+  return u32(completed.size());
+}
+
+u32 FencePool::watchedCount() {
+  std::lock_guard lock{m_mutex};
+  return u32(m_watched.size());
+}
+
+void FencePool::startWatcher() {
+  if (m_running.exchange(true)) {
+    return;
+  }
+  // a watcher that stopped on an error has exited but not been joined
+  if (m_watcher.joinable()) {
+    m_watcher.join();
+  }
+  m_watcherResult.store(VK_SUCCESS);
+  m_watcher = std::thread{&FencePool::watcherLoop, this};
+}
+
+void FencePool::stopWatcher() {
+  m_running.store(false);
+  {
+    // taking the lock orders the store with the watcher's predicate check
+    std::lock_guard lock{m_mutex};
+  }
+  m_wakeup.notify_all();
+  if (m_watcher.joinable()) {
+    m_watcher.join();
+  }
+}
+
+void FencePool::watcherLoop() {
+  while (true) {
+    {
+      std::unique_lock lock{m_mutex};
+      m_wakeup.wait(lock, [this] {
+        return !m_running.load() || !m_watched.empty();
+      });
+      if (!m_running.load()) {
+        return;
+      }
+      m_waiting.clear();
+      for (auto& watched : m_watched) {
+        m_waiting.push_back(watched.fence);
+      }
+    }
+    // a short timeout, so fences watched in the meantime are not starved
+    auto result =
+        vkWaitForFences(m_device, u32(m_waiting.size()), m_waiting.data(),
+                        VK_FALSE, WATCH_TIMEOUT);
+    {
+      std::lock_guard lock{m_mutex};
+      m_waiting.clear();
+      for (auto& fence : m_deferred) {
+        recycle(fence);
+      }
+      m_deferred.clear();
+    }
+    if (result == VK_SUCCESS) {
+      poll();
+    } else if (result != VK_TIMEOUT) {
+      // the fences will not signal, e.g. VK_ERROR_DEVICE_LOST; retrying
+      // would spin, so stop and leave the rest to poll() and destroy()
+      m_watcherResult.store(result);
+      m_running.store(false);
+      return;
+    }
+  }
+}
+} // namespace ezvk
@@ -0,0 +1,76 @@
+#pragma once
+#include "common.hpp"
+
+#include "SyncStructures.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace ezvk {
+// Recycles fences instead of creating one per submission, and tracks
+// submitted fences so completion is reported through callbacks instead of a
+// blocking vkWaitForFences. Completion is picked up by poll() on the caller
+// thread or, after startWatcher(), by a background thread that runs the
+// callbacks itself. All members are safe to call from several threads.
+// Fences are only reset under the pool's lock, and never while the watcher
+// is waiting on them.
+//
+//   Fence fence = pool.acquire();
+//   vkQueueSubmit(queue, 1, &submitInfo, fence);
+//   pool.watch(fence, [&] { readResults(); });
+class FencePool {
+public:
+  using Callback = std::function<void()>;
+
+  // how long the watcher blocks before picking up newly watched fences
+  static constexpr u64 WATCH_TIMEOUT = 1000000; // 1ms
+
+  void create(VkDevice device, u32 initialCount = 0);
+  // waits for every watched fence and runs its callback first
+  void destroy();
+
+  // returns an unsignaled fence
+  Fence acquire();
+  // returns a completed or never submitted fence to the pool
+  void release(Fence fence);
+
+  // `fence` goes back to the pool after `onComplete` has run
+  void watch(Fence fence, Callback onComplete);
+  // runs the callbacks of completed fences, returns how many completed
+  u32  poll();
+  u32  watchedCount();
+
+  void startWatcher();
+  void stopWatcher();
+  // VK_SUCCESS, or the error that stopped the watcher, e.g.
+  // VK_ERROR_DEVICE_LOST
+  VkResult watcherResult() const {
+    return m_watcherResult.load();
+  }
+
+private:
+  struct Watched {
+    Fence    fence;
+    Callback onComplete;
+  };
+
+  void watcherLoop();
+  // with m_mutex held
+  void recycle(Fence fence);
+
+  VkDevice                m_device;
+  std::mutex              m_mutex;
+  std::condition_variable m_wakeup;
+  std::vector<Fence>      m_free;
+  std::vector<Watched>    m_watched;
+  // the watcher's vkWaitForFences snapshot, written under m_mutex by the
+  // watcher only; released fences in it are reset once the wait returns
+  std::vector<VkFence>    m_waiting;
+  std::vector<Fence>      m_deferred;
+  std::thread             m_watcher;
+  std::atomic<bool>       m_running{false};
+  std::atomic<VkResult>   m_watcherResult{VK_SUCCESS};
+};
+} // namespace ezvk
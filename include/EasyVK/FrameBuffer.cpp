@@ -21,23 +21,101 @@ void Framebuffer::create(VkDevice device, vkb::Swapchain& swapchain,
                          VkRenderPass renderPass, VkExtent2D windowExtent,
                          std::vector<VkImageView>& swapchainImageViews,
                          VkImageView depthImageView, VkImageView imageView,
-                         u32 graphicIndex, u32 transferIndex) {
+                         u32 graphicIndex, u32 transferIndex,
+                         u32 framesInFlight) {
+  createFrames(device, graphicIndex, framesInFlight);
+  m_renderPass = renderPass;
+  m_extent     = windowExtent;
+  m_attachments.clear();
+  createFramebuffers(device, windowExtent, swapchainImageViews, depthImageView,
+                     imageView);
+}
+
+VkPhysicalDeviceVulkan12Features Framebuffer::imagelessFeatures() {
+  return {
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+      .pNext = nullptr,
+      .imagelessFramebuffer = VK_TRUE,
+  };
+}
 
+void Framebuffer::createImageless(
+    VkDevice device, VkRenderPass renderPass, VkExtent2D extent,
+    std::vector<ImagelessAttachment> const& attachments, u32 graphicIndex,
+    u32 framesInFlight) {
+  assert(!attachments.empty());
+  createFrames(device, graphicIndex, framesInFlight);
+  m_renderPass  = renderPass;
+  m_extent      = extent;
+  m_attachments = attachments;
+  createImagelessFramebuffer(device, extent);
+}
+
+void Framebuffer::createFrames(VkDevice device, u32 graphicIndex,
+                               u32 framesInFlight) {
+  assert(framesInFlight > 0);
+  this->framesInFlight = framesInFlight;
+  frameData.resize(framesInFlight);
+  timing.create();
   for (auto& frame : frameData) {
     frame.create(device, graphicIndex);
   }
+}
+
+void Framebuffer::createImagelessFramebuffer(VkDevice   device,
+                                             VkExtent2D extent) {
+  std::vector<VkFramebufferAttachmentImageInfo> imageInfos;
+  imageInfos.reserve(m_attachments.size());
+  for (auto const& attachment : m_attachments) {
+    imageInfos.push_back({
+        .sType           = VK_STRUCTURE_TYPE_FRAMEBUFFER_ATTACHMENT_IMAGE_INFO,
+        .pNext           = nullptr,
+        .flags           = attachment.flags,
+        .usage           = attachment.usage,
+        .width           = extent.width,
+        .height          = extent.height,
+        .layerCount      = attachment.layerCount,
+        .viewFormatCount = 1,
+        .pViewFormats    = &attachment.format,
+    });
+  }
+  VkFramebufferAttachmentsCreateInfo attachmentsCI{
+      .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_ATTACHMENTS_CREATE_INFO,
+      .pNext = nullptr,
+      .attachmentImageInfoCount = u32(imageInfos.size()),
+      .pAttachmentImageInfos    = imageInfos.data(),
+  };
+  VkFramebufferCreateInfo CI{
+      .sType           = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+      .pNext           = &attachmentsCI,
+      .flags           = VK_FRAMEBUFFER_CREATE_IMAGELESS_BIT,
+      .renderPass      = m_renderPass,
+      .attachmentCount = u32(imageInfos.size()),
+      .pAttachments    = nullptr,
+      .width           = extent.width,
+      .height          = extent.height,
+      .layers          = 1,
+  };
+  framebuffers.resize(1);
+  auto result = vkCreateFramebuffer(device, &CI, nullptr, &framebuffers[0]);
+  assert(result == VK_SUCCESS);
+}
 
+void Framebuffer::createFramebuffers(
+    VkDevice device, VkExtent2D extent,
+    std::vector<VkImageView>& swapchainImageViews, VkImageView depthImageView,
+    VkImageView imageView) {
   VkFramebufferCreateInfo CI{
       .sType      = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
       .pNext      = nullptr,
       .flags      = 0,
-      .renderPass = renderPass,
-      .width      = windowExtent.width,
-      .height     = windowExtent.height,
+      .renderPass = m_renderPass,
+      .width      = extent.width,
+      .height     = extent.height,
       .layers     = 1,
   };
 
-  u32 swapchainSize = u32(swapchain.image_count);
+  u32 swapchainSize = u32(swapchainImageViews.size());
   framebuffers.resize(swapchainSize);
   for (u32 i = 0; i < swapchainSize; ++i) {
     // std::vector<VkImageView> attachments;
@@ -53,28 +131,93 @@ void Framebuffer::create(VkDevice device, vkb::Swapchain& swapchain,
     assert(result == VK_SUCCESS);
   }
 }
+
+void Framebuffer::refresh(VkDevice device, Swapchain& swapchain,
+                          VkImageView depthImageView, VkImageView imageView) {
+  VkExtent2D extent = swapchain.m_swapchain.extent;
+  bool       resized =
+      extent.width != m_extent.width || extent.height != m_extent.height;
+  // an imageless framebuffer does not reference the swapchain views
+  if (m_generation != swapchain.generation && (!isImageless() || resized)) {
+    m_retired.push_back({std::move(framebuffers), frameCount});
+    framebuffers.clear();
+    if (isImageless()) {
+      createImagelessFramebuffer(device, extent);
+    } else {
+      createFramebuffers(device, extent, swapchain.m_imageViews,
+                         depthImageView, imageView);
+    }
+    m_extent = extent;
+  }
+  m_generation = swapchain.generation;
+
+  // the current frame's fence covers every frame up to this one
+  if (frameCount < framesInFlight) {
+    return;
+  }
+  u64 completedFrame = frameCount - framesInFlight;
+  std::erase_if(m_retired, [&](Retired& retired) {
+    if (retired.frameIndex > completedFrame) {
+      return false;
+    }
+    for (auto framebuffer : retired.framebuffers) {
+      vkDestroyFramebuffer(device, framebuffer, nullptr);
+    }
+    return true;
+  });
+  swapchain.collectRetired(completedFrame);
+}
+
 void Framebuffer::destroy(VkDevice device) {
   for (auto& frame : frameData) {
     frame.destroy(device);
   }
+  frameData.clear();
 
   for (auto& frame : framebuffers) {
     vkDestroyFramebuffer(device, frame, nullptr);
   }
+  for (auto& retired : m_retired) {
+    for (auto framebuffer : retired.framebuffers) {
+      vkDestroyFramebuffer(device, framebuffer, nullptr);
+    }
+  }
+  m_retired.clear();
 }
 
 VkResult Framebuffer::acquireNextImage(VkDevice       device,
                                        VkSwapchainKHR swapchain, u64 timeout,
                                        u32* index) {
-  auto result = vkAcquireNextImageKHR(device, swapchain, 100000000,
+  auto result = vkAcquireNextImageKHR(device, swapchain, timeout,
                                       currentFrameData().presentSemaphore,
                                       nullptr, index);
+  if (result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR) {
+    timing.mark(FrameTiming::AcquireReturned);
+  }
   return result;
 }
 
+VkResult Framebuffer::waitForFrame(VkDevice device, u64 timeout) {
+  FrameTiming::FrameRecord const* record = timing.record(frameCount);
+  if (record == nullptr) {
+    timing.beginFrame(frameCount);
+  }
+  FrameData& frame  = currentFrameData();
+  auto       result = vkWaitForFences(device, 1, &frame.renderFence, VK_TRUE,
+                                      timeout);
+  if (result != VK_SUCCESS) {
+    return result;
+  }
+  // retries keep the first stamp, so Acquire covers every attempt
+  if (record == nullptr || record->marks[FrameTiming::FenceSignaled] < 0.0) {
+    timing.mark(FrameTiming::FenceSignaled);
+  }
+  return VK_SUCCESS;
+}
+
 void Framebuffer::freeCmdBuffer(VkDevice device) {
   for (FrameData& frame : frameData) {
-    frame.cmdBuffer.free(device, frameData->mainCmdPool);
+    frame.cmdBuffer.free(device, frame.mainCmdPool);
   }
 }
 } // namespace ezvk
\ No newline at end of file
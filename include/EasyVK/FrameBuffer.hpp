@@ -2,9 +2,11 @@
 #include "common.hpp"
 
 #include "Command.hpp"
+#include "FrameTiming.hpp"
 #include "SyncStructures.hpp"
 
 namespace ezvk {
+class Swapchain;
 class Framebuffer {
 public:
   struct FrameData {
@@ -17,28 +19,104 @@ public:
     void destroy(VkDevice device);
   };
 
-  static constexpr u32 DATA_COUNT = 1;
+  // Describes an attachment of an imageless framebuffer; any view created
+  // with matching parameters can be bound at beginRenderPass.
+  struct ImagelessAttachment {
+    VkImageUsageFlags  usage;
+    VkFormat           format;
+    VkImageCreateFlags flags{0};
+    u32                layerCount{1};
+  };
+
+  // 2 lets the CPU record frame N+1 while the GPU renders frame N, 3 also
+  // hides a frame that runs long on either side
+  static constexpr u32 DEFAULT_FRAMES_IN_FLIGHT = 2;
 
-  u64       frameCount{0};
-  FrameData frameData[DATA_COUNT];
+  u64                    frameCount{0};
+  u32                    framesInFlight{DEFAULT_FRAMES_IN_FLIGHT};
+  std::vector<FrameData> frameData;
 
   std::vector<VkFramebuffer> framebuffers;
+  // Begin, FenceSignaled and AcquireReturned are marked here, the rest by
+  // the caller
+  FrameTiming                timing;
 
   void create(VkDevice device, vkb::Swapchain& swapchain,
               VkRenderPass renderPass, VkExtent2D windowExtent,
               std::vector<VkImageView>& swapchainImageViews,
               VkImageView depthImageView, VkImageView imageViews,
-              u32 graphicIndex, u32 transferIndex);
+              u32 graphicIndex, u32 transferIndex,
+              u32 framesInFlight = DEFAULT_FRAMES_IN_FLIGHT);
+  // Vulkan 1.2 / VK_KHR_imageless_framebuffer: a single VkFramebuffer for
+  // every swapchain image, the views are passed to
+  // CommandBuffer::beginRenderPass(pRenderPassBI, attachments, contents).
+  // The device must be created with the imagelessFramebuffer feature, see
+  // imagelessFeatures().
+  void createImageless(VkDevice device, VkRenderPass renderPass,
+                       VkExtent2D                              extent,
+                       std::vector<ImagelessAttachment> const& attachments,
+                       u32                                     graphicIndex,
+                       u32 framesInFlight = DEFAULT_FRAMES_IN_FLIGHT);
   void destroy(VkDevice device);
+  // merge into Features12 (Extensions.hpp) before creating the device
+  static VkPhysicalDeviceVulkan12Features imagelessFeatures();
+  bool isImageless() const {
+    return !m_attachments.empty();
+  }
+  VkFramebuffer framebufferFor(u32 imageIndex) const {
+    return isImageless() ? framebuffers[0] : framebuffers[imageIndex];
+  }
+  // Rebuilds the framebuffers if `swapchain` was recreated since they were
+  // built, with the attachments passed in at their new size (an imageless
+  // framebuffer only if the extent changed), and frees what
+  // earlier rebuilds and Swapchain::recreate() retired once no frame in
+  // flight can use it. Call once per frame, after waitForFrame().
+  void refresh(VkDevice device, Swapchain& swapchain,
+               VkImageView depthImageView, VkImageView imageView);
 
-  // using present semaphore
+  // Signals the current frame's present semaphore. With a timeout of 0 it
+  // never blocks and returns VK_NOT_READY if no image is available yet, so
+  // the caller can keep processing input and retry.
   VkResult acquireNextImage(VkDevice device, VkSwapchainKHR swapchain,
                             u64 timeout, u32* index);
   void     freeCmdBuffer(VkDevice device);
 
   FrameData& currentFrameData() {
-    FrameData& frame = frameData[frameCount % DATA_COUNT];
+    FrameData& frame = frameData[frameCount % framesInFlight];
     return frame;
   }
+  // Waits until the GPU is done with the current frame's resources, the
+  // submit from `framesInFlight` frames ago. May be called again until an
+  // image is acquired; the frame is stamped in `timing` once.
+  VkResult   waitForFrame(VkDevice device, u64 timeout);
+  // Resets the current frame's fence. Call after acquireNextImage()
+  // succeeded, right before the submit that signals the fence, so a failed
+  // or retried acquire never leaves an unsignaled fence that the next
+  // waitForFrame() would block on forever.
+  VkResult   resetFence(VkDevice device) {
+    return currentFrameData().renderFence.reset(device);
+  }
+  // rotates to the next frame's resources, call after presenting
+  void       nextFrame() {
+    ++frameCount;
+  }
+
+private:
+  struct Retired {
+    std::vector<VkFramebuffer> framebuffers;
+    u64                        frameIndex;
+  };
+
+  void createFrames(VkDevice device, u32 graphicIndex, u32 framesInFlight);
+  void createFramebuffers(VkDevice device, VkExtent2D extent,
+                          std::vector<VkImageView>& swapchainImageViews,
+                          VkImageView depthImageView, VkImageView imageView);
+  void createImagelessFramebuffer(VkDevice device, VkExtent2D extent);
+
+  VkRenderPass                     m_renderPass;
+  VkExtent2D                       m_extent;
+  std::vector<ImagelessAttachment> m_attachments;
+  u64                              m_generation{0};
+  std::vector<Retired>             m_retired;
 };
 } // namespace ezvk
\ No newline at end of file
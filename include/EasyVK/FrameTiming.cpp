@@ -0,0 +1,272 @@
+#include "FrameTiming.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <span>
+
+namespace ezvk {
+static constexpr u64 NO_FRAME = ~u64(0);
+
+static ccstr const MARK_NAMES[FrameTiming::MarkCount]{
+    "begin", "fence_signaled", "acquire_returned",
+    "record_done", "submit", "present",
+};
+
+ccstr FrameTiming::intervalName(Interval interval) {
+  static ccstr const names[IntervalCount]{
+      "frame_time", "fence_wait", "acquire", "record",
+      "submit",     "present",    "gpu",     "present_latency",
+  };
+  return names[interval];
+}
+
+void FrameTiming::create() {
+  m_epoch = std::chrono::steady_clock::now();
+  for (auto& record : m_records) {
+    record = {};
+    std::fill(std::begin(record.marks), std::end(record.marks), -1.0);
+  }
+  m_current       = NO_FRAME;
+  m_nextDisplayed = NO_FRAME;
+}
+
+double FrameTiming::now() const {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - m_epoch)
+      .count();
+}
+
+void FrameTiming::beginFrame(u64 frameIndex) {
+  m_current           = frameIndex;
+  FrameRecord& record = slot(frameIndex);
+  record              = {.frameIndex = frameIndex};
+  std::fill(std::begin(record.marks), std::end(record.marks), -1.0);
+  record.marks[Begin] = now();
+}
+
+void FrameTiming::mark(Mark mark) {
+  if (m_current == NO_FRAME) {
+    return;
+  }
+  slot(m_current).marks[mark] = now();
+}
+
+void FrameTiming::setGpuTime(u64 frameIndex, double gpuMs) {
+  FrameRecord& record = slot(frameIndex);
+  if (record.frameIndex == frameIndex) {
+    record.gpuMs = gpuMs;
+  }
+}
+
+bool FrameTiming::loadPresentWait(VkDevice device) {
+  m_fpWaitForPresent = reinterpret_cast<PFN_vkWaitForPresentKHR>(
+      vkGetDeviceProcAddr(device, "vkWaitForPresentKHR"));
+  return m_fpWaitForPresent != nullptr;
+}
+
+VkPresentIdKHR* FrameTiming::presentId() {
+  assert(m_current != NO_FRAME);
+  if (m_nextDisplayed == NO_FRAME) {
+    m_nextDisplayed = m_current;
+  }
+  // ids must be non-zero and increasing
+  m_presentIdValue = m_current + 1;
+  m_presentIdInfo  = {
+       .sType          = VK_STRUCTURE_TYPE_PRESENT_ID_KHR,
+       .pNext          = nullptr,
+       .swapchainCount = 1,
+       .pPresentIds    = &m_presentIdValue,
+  };
+  return &m_presentIdInfo;
+}
+
+void FrameTiming::pollPresented(VkDevice device, VkSwapchainKHR swapchain) {
+  if (m_fpWaitForPresent == nullptr || m_nextDisplayed == NO_FRAME) {
+    return;
+  }
+  // the stamp is taken when the poll notices, so poll once per frame or more
+  while (m_nextDisplayed <= m_current) {
+    u64  presentId = m_nextDisplayed + 1;
+    auto result    = m_fpWaitForPresent(device, swapchain, presentId, 0);
+    if (result != VK_SUCCESS) {
+      break;
+    }
+    FrameRecord& record = slot(m_nextDisplayed);
+    if (record.frameIndex == m_nextDisplayed) {
+      record.displayedMs = now();
+    }
+    ++m_nextDisplayed;
+  }
+}
+
+FrameTiming::FrameRecord const* FrameTiming::record(u64 frameIndex) const {
+  FrameRecord const& record = m_records[frameIndex % WINDOW_SIZE];
+  return record.frameIndex == frameIndex ? &record : nullptr;
+}
+
+std::optional<double> FrameTiming::intervalOf(FrameRecord const& record,
+                                              Interval interval) const {
+  auto between = [&](Mark from, Mark to) -> std::optional<double> {
+    if (record.marks[from] < 0.0 || record.marks[to] < 0.0) {
+      return std::nullopt;
+    }
+    return record.marks[to] - record.marks[from];
+  };
+  switch (interval) {
+  case FrameTime: {
+    FrameRecord const* next = this->record(record.frameIndex + 1);
+    if (next == nullptr) {
+      return std::nullopt;
+    }
+    return next->marks[Begin] - record.marks[Begin];
+  }
+  case FenceWait:
+    return between(Begin, FenceSignaled);
+  case Acquire:
+    return between(FenceSignaled, AcquireReturned);
+  case Record:
+    return between(AcquireReturned, RecordDone);
+  case SubmitCall:
+    return between(RecordDone, Submit);
+  case PresentCall:
+    return between(Submit, Present);
+  case Gpu:
+    if (record.gpuMs < 0.0) {
+      return std::nullopt;
+    }
+    return record.gpuMs;
+  case PresentLatency:
+    if (record.displayedMs < 0.0 || record.marks[Present] < 0.0) {
+      return std::nullopt;
+    }
+    return record.displayedMs - record.marks[Present];
+  default:
+    return std::nullopt;
+  }
+}
+
+FrameTiming::Percentiles FrameTiming::interval(Interval interval) const {
+  std::vector<double> samples;
+  samples.reserve(WINDOW_SIZE);
+  for (auto const& record : m_records) {
+    if (record.frameIndex == NO_FRAME) {
+      continue;
+    }
+    if (auto value = intervalOf(record, interval); value.has_value()) {
+      samples.push_back(*value);
+    }
+  }
+  if (samples.empty()) {
+    return {};
+  }
+  std::sort(samples.begin(), samples.end());
+  // nearest rank
+  auto at = [&](double p) {
+    size_t rank = size_t(std::ceil(p * double(samples.size())));
+    return samples[std::max<size_t>(rank, 1) - 1];
+  };
+  return {at(0.50), at(0.95), at(0.99), u32(samples.size())};
+}
+
+// oldest first
+static std::vector<FrameTiming::FrameRecord const*>
+orderedRecords(std::span<FrameTiming::FrameRecord const> records) {
+  std::vector<FrameTiming::FrameRecord const*> ordered;
+  for (auto const& record : records) {
+    if (record.frameIndex != NO_FRAME) {
+      ordered.push_back(&record);
+    }
+  }
+  std::sort(ordered.begin(), ordered.end(), [](auto* lhs, auto* rhs) {
+    return lhs->frameIndex < rhs->frameIndex;
+  });
+  return ordered;
+}
+
+static void appendNumber(std::string& out, std::optional<double> value,
+                         ccstr missing) {
+  if (!value.has_value()) {
+    out += missing;
+    return;
+  }
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%.4f", *value);
+  out += buffer;
+}
+
+std::string FrameTiming::csv() const {
+  std::string out = "frame";
+  for (auto name : MARK_NAMES) {
+    out += ',';
+    out += name;
+  }
+  for (u32 i = 0; i < IntervalCount; ++i) {
+    out += ',';
+    out += intervalName(Interval(i));
+  }
+  out += '\n';
+
+  for (auto const* record : orderedRecords(m_records)) {
+    out += std::to_string(record->frameIndex);
+    for (double mark : record->marks) {
+      out += ',';
+      appendNumber(out, mark < 0.0 ? std::nullopt : std::optional{mark}, "");
+    }
+    for (u32 i = 0; i < IntervalCount; ++i) {
+      out += ',';
+      appendNumber(out, intervalOf(*record, Interval(i)), "");
+    }
+    out += '\n';
+  }
+  return out;
+}
+
+std::string FrameTiming::json() const {
+  std::string out = "{\"frames\":[";
+  bool        firstFrame = true;
+  for (auto const* record : orderedRecords(m_records)) {
+    out += firstFrame ? "{" : ",{";
+    firstFrame = false;
+    out += "\"frame\":" + std::to_string(record->frameIndex);
+    for (u32 i = 0; i < MarkCount; ++i) {
+      out += std::string(",\"") + MARK_NAMES[i] + "\":";
+      double mark = record->marks[i];
+      appendNumber(out, mark < 0.0 ? std::nullopt : std::optional{mark},
+                   "null");
+    }
+    for (u32 i = 0; i < IntervalCount; ++i) {
+      out += std::string(",\"") + intervalName(Interval(i)) + "\":";
+      appendNumber(out, intervalOf(*record, Interval(i)), "null");
+    }
+    out += '}';
+  }
+  out += "],\"percentiles\":{";
+  for (u32 i = 0; i < IntervalCount; ++i) {
+    Percentiles stats = interval(Interval(i));
+    if (i != 0) {
+      out += ',';
+    }
+    out += std::string("\"") + intervalName(Interval(i)) + "\":{\"p50\":";
+    appendNumber(out, stats.p50, "null");
+    out += ",\"p95\":";
+    appendNumber(out, stats.p95, "null");
+    out += ",\"p99\":";
+    appendNumber(out, stats.p99, "null");
+    out += ",\"samples\":" + std::to_string(stats.sampleCount) + '}';
+  }
+  out += "}}\n";
+  return out;
+}
+
+bool FrameTiming::dump(std::string const& path) const {
+  bool        asJson = path.ends_with(".json");
+  std::string text   = asJson ? json() : csv();
+  FILE*       fp     = ::fopen(path.c_str(), "wb");
+  if (fp == nullptr) {
+    return false;
+  }
+  bool written = ::fwrite(text.data(), 1, text.size(), fp) == text.size();
+  ::fclose(fp);
+  return written;
+}
+} // namespace ezvk
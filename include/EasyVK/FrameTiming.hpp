@@ -0,0 +1,102 @@
+#pragma once
+#include "common.hpp"
+
+#include <chrono>
+#include <string>
+
+namespace ezvk {
+// Per-frame CPU timestamps of the stages of a frame, plus the GPU time and,
+// with VK_KHR_present_wait, the time the frame was actually displayed.
+// Statistics cover the last WINDOW_SIZE complete frames.
+class FrameTiming {
+public:
+  static constexpr u32 WINDOW_SIZE = 256;
+
+  // in the order they happen within a frame
+  enum Mark : u32 {
+    Begin,
+    FenceSignaled,
+    AcquireReturned,
+    RecordDone,
+    Submit,
+    Present,
+    MarkCount,
+  };
+  // durations derived from the marks, in milliseconds
+  enum Interval : u32 {
+    FrameTime, // Begin to the next frame's Begin
+    FenceWait, // Begin to FenceSignaled
+    Acquire,   // FenceSignaled to AcquireReturned
+    Record,    // AcquireReturned to RecordDone
+    SubmitCall,
+    PresentCall,
+    Gpu,            // from setGpuTime()
+    PresentLatency, // Present to displayed, needs present wait
+    IntervalCount,
+  };
+
+  struct Percentiles {
+    double p50{0.0};
+    double p95{0.0};
+    double p99{0.0};
+    u32    sampleCount{0};
+  };
+
+  struct FrameRecord {
+    u64    frameIndex{~u64(0)};
+    // milliseconds since create(), negative if not marked
+    double marks[MarkCount];
+    double gpuMs{-1.0};
+    double displayedMs{-1.0};
+  };
+
+  void create();
+
+  // starts frame `frameIndex` and stamps its Begin mark
+  void beginFrame(u64 frameIndex);
+  void mark(Mark mark);
+  // GPU results arrive frames later, so they are matched by index
+  void setGpuTime(u64 frameIndex, double gpuMs);
+
+  // Optional. Needs VK_KHR_present_id and VK_KHR_present_wait enabled on the
+  // device; returns false if vkWaitForPresentKHR is unavailable.
+  bool loadPresentWait(VkDevice device);
+  bool presentWaitSupported() const {
+    return m_fpWaitForPresent != nullptr;
+  }
+  // chain into VkPresentInfoKHR::pNext for the current frame
+  VkPresentIdKHR* presentId();
+  // stamps displayedMs of the frames presented since the last call, never
+  // blocks
+  void pollPresented(VkDevice device, VkSwapchainKHR swapchain);
+
+  [[nodiscard]] Percentiles interval(Interval interval) const;
+  [[nodiscard]] std::optional<double> intervalOf(FrameRecord const& record,
+                                                 Interval interval) const;
+  [[nodiscard]] FrameRecord const* record(u64 frameIndex) const;
+
+  // one line per frame in the window, oldest first
+  [[nodiscard]] std::string csv() const;
+  // {"frames": [...], "percentiles": {...}}
+  [[nodiscard]] std::string json() const;
+  // JSON if `path` ends in ".json", CSV otherwise
+  bool dump(std::string const& path) const;
+
+  static ccstr intervalName(Interval interval);
+
+private:
+  FrameRecord& slot(u64 frameIndex) {
+    return m_records[frameIndex % WINDOW_SIZE];
+  }
+  double now() const;
+
+  std::chrono::steady_clock::time_point m_epoch;
+  FrameRecord                           m_records[WINDOW_SIZE];
+  u64                                   m_current{~u64(0)};
+  u64                                   m_nextDisplayed{0};
+
+  PFN_vkWaitForPresentKHR m_fpWaitForPresent{nullptr};
+  VkPresentIdKHR          m_presentIdInfo;
+  u64                     m_presentIdValue;
+};
+} // namespace ezvk
@@ -0,0 +1,272 @@
+#include "Offscreen.hpp"
+
+namespace ezvk {
+// 0 for formats the readback does not handle
+static u32 texelSize(VkFormat format) {
+  switch (format) {
+  case VK_FORMAT_R8G8B8A8_UNORM:
+  case VK_FORMAT_R8G8B8A8_SRGB:
+  case VK_FORMAT_B8G8R8A8_UNORM:
+  case VK_FORMAT_B8G8R8A8_SRGB:
+  case VK_FORMAT_A2B10G10R10_UNORM_PACK32:
+  case VK_FORMAT_R32_SFLOAT:
+  case VK_FORMAT_R32_UINT:
+    return 4;
+  case VK_FORMAT_R16G16B16A16_SFLOAT:
+  case VK_FORMAT_R32G32_SFLOAT:
+    return 8;
+  case VK_FORMAT_R32G32B32A32_SFLOAT:
+    return 16;
+  default:
+    return 0;
+  }
+}
+
+VkResult OffscreenTarget::create(VkDevice device, BufferAllocator& allocator,
+                                 VkQueue queue, u32 queueFamilyIndex,
+                                 VkExtent2D extent, VkFormat format,
+                                 u32 imageCount, VkImageLayout renderedLayout,
+                                 VkImageUsageFlags extraUsage) {
+  if (texelSize(format) == 0) {
+    return VK_ERROR_FORMAT_NOT_SUPPORTED;
+  }
+  this->extent = extent;
+  this->format = format;
+  m_allocator  = allocator.m_allocator;
+  m_queue      = queue;
+  m_frameSize  = VkDeviceSize(extent.width) * extent.height * texelSize(format);
+  m_next       = 0;
+  m_frameCount = 0;
+  m_cmdPool.create(device, 0, queueFamilyIndex);
+
+  VkImageCreateInfo imageCI{
+      .sType                 = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+      .pNext                 = nullptr,
+      .flags                 = 0,
+      .imageType             = VK_IMAGE_TYPE_2D,
+      .format                = format,
+      .extent                = {extent.width, extent.height, 1},
+      .mipLevels             = 1,
+      .arrayLayers           = 1,
+      .samples               = VK_SAMPLE_COUNT_1_BIT,
+      .tiling                = VK_IMAGE_TILING_OPTIMAL,
+      .usage                 = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+                               VK_IMAGE_USAGE_TRANSFER_SRC_BIT | extraUsage,
+      .sharingMode           = VK_SHARING_MODE_EXCLUSIVE,
+      .queueFamilyIndexCount = 0,
+      .pQueueFamilyIndices   = nullptr,
+      .initialLayout         = VK_IMAGE_LAYOUT_UNDEFINED,
+  };
+  VmaAllocationCreateInfo imageAI{
+      .usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
+  };
+  VkBufferCreateInfo bufferCI{
+      .sType                 = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+      .pNext                 = nullptr,
+      .flags                 = 0,
+      .size                  = m_frameSize,
+      .usage                 = VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+      .sharingMode           = VK_SHARING_MODE_EXCLUSIVE,
+      .queueFamilyIndexCount = 0,
+      .pQueueFamilyIndices   = nullptr,
+  };
+  VmaAllocationCreateInfo bufferAI{
+      .flags = VMA_ALLOCATION_CREATE_MAPPED_BIT |
+               VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT,
+      .usage = VMA_MEMORY_USAGE_AUTO,
+  };
+  auto range = defaultImageSubresourceRange(VK_IMAGE_ASPECT_COLOR_BIT);
+
+  m_images.resize(imageCount);
+  m_imageViews.resize(imageCount);
+  m_slots.resize(imageCount);
+  for (u32 i = 0; i < imageCount; ++i) {
+    m_images[i]      = allocator.createImage(&imageCI, &imageAI, nullptr);
+    m_images[i].size = m_frameSize;
+
+    ImageView view;
+    view.create(device, m_images[i], VK_IMAGE_VIEW_TYPE_2D, format, {}, range);
+    m_imageViews[i] = view.imageView;
+
+    Slot&             slot = m_slots[i];
+    VmaAllocationInfo info;
+    slot.readback = allocator.createBuffer(&bufferCI, &bufferAI, &info);
+    slot.mapped   = info.pMappedData;
+    assert(slot.mapped != nullptr);
+    slot.fence.create(device, 0);
+    slot.readDone.create(device);
+    slot.readDoneSignaled = false;
+
+    // the copy never changes, so it is recorded once and resubmitted
+    VkImageMemoryBarrier toTransfer{
+        .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .pNext               = nullptr,
+        .srcAccessMask       = VK_ACCESS_MEMORY_WRITE_BIT,
+        .dstAccessMask       = VK_ACCESS_TRANSFER_READ_BIT,
+        .oldLayout           = renderedLayout,
+        .newLayout           = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image               = m_images[i],
+        .subresourceRange    = range,
+    };
+    VkBufferImageCopy region{
+        .bufferOffset      = 0,
+        .bufferRowLength   = 0,
+        .bufferImageHeight = 0,
+        .imageSubresource  = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1},
+        .imageOffset       = {0, 0, 0},
+        .imageExtent       = {extent.width, extent.height, 1},
+    };
+    VkBufferMemoryBarrier toHost{
+        .sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        .pNext               = nullptr,
+        .srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask       = VK_ACCESS_HOST_READ_BIT,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .buffer              = slot.readback,
+        .offset              = 0,
+        .size                = VK_WHOLE_SIZE,
+    };
+    // the readback's semaphore signal orders the next rendering after this
+    VkImageMemoryBarrier toRendered{
+        .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .pNext               = nullptr,
+        .srcAccessMask       = 0,
+        .dstAccessMask       = 0,
+        .oldLayout           = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        .newLayout           = renderedLayout,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image               = m_images[i],
+        .subresourceRange    = range,
+    };
+    slot.cmd.alloc(device, m_cmdPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+    slot.cmd.begin(0);
+    slot.cmd
+        .pipelineImageBarrier(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                              VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1,
+                              &toTransfer)
+        .copyImageToBuffer(m_images[i], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                           slot.readback, 1, &region)
+        .pipelineBufferBarrier(VK_PIPELINE_STAGE_TRANSFER_BIT,
+                               VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &toHost)
+        .pipelineImageBarrier(VK_PIPELINE_STAGE_TRANSFER_BIT,
+                              VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 1,
+                              &toRendered)
+        .end();
+  }
+  return VK_SUCCESS;
+}
+
+void OffscreenTarget::destroy(VkDevice device, BufferAllocator& allocator) {
+  for (u32 i = 0; i < u32(m_slots.size()); ++i) {
+    u32 index = (m_next + i) % u32(m_slots.size());
+    if (m_slots[index].pending) {
+      vkWaitForFences(device, 1, &m_slots[index].fence, VK_TRUE,
+                      TimelineSemaphore::NO_TIMEOUT);
+      deliver(index);
+    }
+  }
+  for (u32 i = 0; i < u32(m_slots.size()); ++i) {
+    m_slots[i].cmd.free(device, m_cmdPool);
+    m_slots[i].fence.destroy(device);
+    m_slots[i].readDone.destroy(device);
+    allocator.destroyBuffer(m_slots[i].readback);
+    vkDestroyImageView(device, m_imageViews[i], nullptr);
+    allocator.destroyImage(m_images[i]);
+  }
+  m_slots.clear();
+  m_imageViews.clear();
+  m_images.clear();
+  m_cmdPool.destroy(device);
+}
+
+VkResult OffscreenTarget::acquireNextImage(VkDevice     device, u64 timeout,
+                                           VkSemaphore* waitSemaphore,
+                                           u32*         index) {
+  Slot& slot = m_slots[m_next];
+  if (slot.pending) {
+    auto result = vkWaitForFences(device, 1, &slot.fence, VK_TRUE, timeout);
+    if (result == VK_TIMEOUT && timeout == 0) {
+      return VK_NOT_READY;
+    }
+    if (result != VK_SUCCESS) {
+      return result;
+    }
+    deliver(m_next);
+  }
+
+  // the wait consumes the binary semaphore, so it is handed out once
+  *waitSemaphore = slot.readDoneSignaled ? slot.readDone.semaphore
+                                         : VK_NULL_HANDLE;
+  slot.readDoneSignaled = false;
+  *index                = m_next;
+  m_next = (m_next + 1) % u32(m_slots.size());
+  return VK_SUCCESS;
+}
+
+VkResult OffscreenTarget::present(VkDevice device, VkSemaphore waitSemaphore,
+                                  u32 index) {
+  Slot& slot = m_slots[index];
+  assert(!slot.pending);
+  slot.fence.reset(device);
+
+  assert(!slot.readDoneSignaled);
+  VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+  VkSubmitInfo submitInfo{
+      .sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+      .pNext                = nullptr,
+      .waitSemaphoreCount   = waitSemaphore != VK_NULL_HANDLE ? 1u : 0u,
+      .pWaitSemaphores      = &waitSemaphore,
+      .pWaitDstStageMask    = &waitStage,
+      .commandBufferCount   = 1,
+      .pCommandBuffers      = &slot.cmd.cmdBuffer,
+      .signalSemaphoreCount = 1,
+      .pSignalSemaphores    = &slot.readDone.semaphore,
+  };
+  auto result = vkQueueSubmit(m_queue, 1, &submitInfo, slot.fence);
+  if (result == VK_SUCCESS) {
+    slot.pending          = true;
+    slot.readDoneSignaled = true;
+    slot.frameIndex       = m_frameCount++;
+  }
+  return result;
+}
+
+u32 OffscreenTarget::poll(VkDevice device) {
+  u32 delivered = 0;
+  // oldest first, so the consumer sees frames in order
+  for (u32 i = 0; i < u32(m_slots.size()); ++i) {
+    u32   index = (m_next + i) % u32(m_slots.size());
+    Slot& slot  = m_slots[index];
+    if (!slot.pending) {
+      continue;
+    }
+    if (vkGetFenceStatus(device, slot.fence) != VK_SUCCESS) {
+      break;
+    }
+    deliver(index);
+    ++delivered;
+  }
+  return delivered;
+}
+
+void OffscreenTarget::deliver(u32 index) {
+  Slot& slot   = m_slots[index];
+  slot.pending = false;
+  vmaInvalidateAllocation(m_allocator, slot.readback.allocation, 0,
+                          VK_WHOLE_SIZE);
+  if (m_consumer) {
+    m_consumer({
+        .imageIndex = index,
+        .frameIndex = slot.frameIndex,
+        .extent     = extent,
+        .format     = format,
+        .pixels     = slot.mapped,
+        .size       = m_frameSize,
+    });
+  }
+}
+} // namespace ezvk
@@ -0,0 +1,92 @@
+#pragma once
+#include "common.hpp"
+
+#include "BufferAllocator.hpp"
+#include "Command.hpp"
+#include "SyncStructures.hpp"
+
+namespace ezvk {
+// A finished frame; `pixels` is only valid during the consumer callback.
+struct OffscreenFrame {
+  u32          imageIndex;
+  u64          frameIndex;
+  VkExtent2D   extent;
+  VkFormat     format;
+  const void*  pixels;
+  VkDeviceSize size;
+};
+
+// Headless stand-in for a swapchain: N images rendered to in turn, with the
+// same acquire/present flow. present() submits a copy of the image into a
+// persistently mapped buffer, and the frame goes to the consumer once that
+// copy has completed, from poll() or when the image comes round again, so
+// readback overlaps with rendering the next frames.
+class OffscreenTarget {
+public:
+  using Consumer = std::function<void(OffscreenFrame const&)>;
+
+  VkExtent2D                  extent;
+  VkFormat                    format;
+  std::vector<AllocatedImage> m_images;
+  std::vector<VkImageView>    m_imageViews;
+
+  // Rendering must leave the image in `renderedLayout`, and the readback
+  // returns it to that layout. The usage always includes COLOR_ATTACHMENT
+  // and TRANSFER_SRC. Returns VK_ERROR_FORMAT_NOT_SUPPORTED, having created
+  // nothing, for formats without a known texel size (packed 8-bit RGBA/BGRA,
+  // A2B10G10R10, and 32-bit float/uint up to four channels, 16-bit float RGBA).
+  VkResult create(VkDevice device, BufferAllocator& allocator, VkQueue queue,
+                  u32 queueFamilyIndex, VkExtent2D extent, VkFormat format,
+                  u32 imageCount = 3,
+                  VkImageLayout renderedLayout =
+                      VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                  VkImageUsageFlags extraUsage = 0);
+  // hands over the frames still being read back first
+  void destroy(VkDevice device, BufferAllocator& allocator);
+
+  void setConsumer(Consumer consumer) {
+    m_consumer = std::move(consumer);
+  }
+
+  // Like vkAcquireNextImageKHR, except the semaphore belongs to the target:
+  // `*waitSemaphore` is signaled by the image's previous readback and the
+  // rendering submit must wait on it, or VK_NULL_HANDLE the first time an
+  // image is used. Returns VK_NOT_READY with a timeout of 0, and VK_TIMEOUT
+  // otherwise, if its previous frame is still being read back.
+  VkResult acquireNextImage(VkDevice device, u64 timeout,
+                            VkSemaphore* waitSemaphore, u32* index);
+  // Like vkQueuePresentKHR: reads `index` back once `waitSemaphore`, which
+  // the rendering submit signals, is.
+  VkResult present(VkDevice device, VkSemaphore waitSemaphore, u32 index);
+  // hands completed frames to the consumer, returns how many
+  u32      poll(VkDevice device);
+
+  u32 getImageCount() {
+    return u32(m_images.size());
+  }
+
+private:
+  struct Slot {
+    AllocatedBuffer readback;
+    const void*     mapped;
+    CommandBuffer   cmd;
+    Fence           fence;
+    // signaled by the readback, waited on by the next rendering submit
+    Semaphore       readDone;
+    bool            readDoneSignaled{false};
+    bool            pending{false};
+    u64             frameIndex{0};
+  };
+
+  void deliver(u32 index);
+
+  VmaAllocator      m_allocator;
+  VkQueue           m_queue;
+  CommandPool       m_cmdPool;
+  std::vector<Slot> m_slots;
+  VkDeviceSize      m_frameSize;
+  Consumer          m_consumer;
+  u32               m_next{0};
+  u64               m_frameCount{0};
+};
+} // namespace ezvk
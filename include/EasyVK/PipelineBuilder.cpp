@@ -137,6 +137,28 @@ VkPipeline GraphicPipelineBuilder::build(VkDevice         device,
                                          VkPipelineLayout layout,
                                          bool             enableTessellation,
                                          VkPipelineCache  cache) {
+  return build(device, renderPass, nullptr, 1, layout, enableTessellation,
+               cache);
+}
+
+VkPipeline GraphicPipelineBuilder::build(
+    VkDevice device, DynamicRendering const& ext,
+    VkPipelineRenderingCreateInfo const& renderingInfo,
+    VkPipelineLayout layout, bool enableTessellation, VkPipelineCache cache) {
+  // the pipeline is only usable with the extension's commands
+  assert(ext.supported());
+  return build(device, VK_NULL_HANDLE, &renderingInfo,
+               renderingInfo.colorAttachmentCount, layout, enableTessellation,
+               cache);
+}
+
+VkPipeline GraphicPipelineBuilder::build(VkDevice         device,
+                                         VkRenderPass     renderPass,
+                                         const void*      pNext,
+                                         u32              colorAttachmentCount,
+                                         VkPipelineLayout layout,
+                                         bool             enableTessellation,
+                                         VkPipelineCache  cache) {
   GraphicPipelineBuilder* builder = this;
 
   VkPipelineDynamicStateCreateInfo dynamicCI;
@@ -169,19 +191,22 @@ VkPipeline GraphicPipelineBuilder::build(VkDevice         device,
       .pScissors     = builder->scissors.data(),
   };
 
+  std::vector<VkPipelineColorBlendAttachmentState> blendAttachments(
+      colorAttachmentCount, builder->colorBlendAttachment);
+
   VkPipelineColorBlendStateCreateInfo colorBlending{
       .sType         = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
       .pNext         = nullptr,
       .flags         = 0,
       .logicOpEnable = VK_FALSE,
       .logicOp       = VK_LOGIC_OP_COPY,
-      .attachmentCount = 1,
-      .pAttachments    = &builder->colorBlendAttachment,
+      .attachmentCount = colorAttachmentCount,
+      .pAttachments    = blendAttachments.data(),
   };
 
   VkGraphicsPipelineCreateInfo pipelineCI{
       .sType               = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
-      .pNext               = nullptr,
+      .pNext               = pNext,
       .flags               = 0,
       .stageCount          = u32(shaders.size()),
       .pStages             = shaders.data(),
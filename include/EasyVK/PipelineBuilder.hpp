@@ -1,6 +1,9 @@
 #pragma once
 #include "common.hpp"
 
+#include "Extensions.hpp"
+#include "PushConstants.hpp"
+
 namespace ezvk {
 struct PipelineLayout {
   VkPipelineLayout layout;
@@ -25,6 +28,17 @@ struct PipelineLayout {
     return vkCreatePipelineLayout(device, &CI, nullptr, &layout);
   }
 
+  // push-constant ranges derived from the given block types
+  template <typename... Blocks>
+  VkResult create(VkDevice                             device,
+                  std::vector<VkDescriptorSetLayout>&& setLayout) {
+    static_assert(pushStagesDisjoint<Blocks...>(),
+                  "push-constant blocks of one layout must not share a "
+                  "stage; declare pushStages on each block");
+    return create(device, std::move(setLayout),
+                  {PushConstants<Blocks>::range()...});
+  }
+
   void destroy(VkDevice device) {
     return vkDestroyPipelineLayout(device, layout, nullptr);
   }
@@ -56,12 +70,24 @@ public:
   VkPipeline build(VkDevice device, VkRenderPass pass, VkPipelineLayout layout,
                    bool            enableTessellation = false,
                    VkPipelineCache cache              = VK_NULL_HANDLE);
+  // dynamic rendering: attachment formats instead of a render pass, one
+  // color blend attachment per color format
+  VkPipeline build(VkDevice device, DynamicRendering const& ext,
+                   VkPipelineRenderingCreateInfo const& renderingInfo,
+                   VkPipelineLayout                     layout,
+                   bool            enableTessellation = false,
+                   VkPipelineCache cache              = VK_NULL_HANDLE);
 
   std::pair<VkPipeline, VkPipelineCache>
   buildWithCache(VkDevice device, VkRenderPass pass, VkPipelineLayout layout,
                  VkPipelineCache cache  = VK_NULL_HANDLE,
                  size_t initialDataSize = 0, void* pInitialData = nullptr);
 
+private:
+  VkPipeline build(VkDevice device, VkRenderPass pass, const void* pNext,
+                   u32 colorAttachmentCount, VkPipelineLayout layout,
+                   bool enableTessellation, VkPipelineCache cache);
+
 public:
   GraphicPipelineBuilder&
   setShader(std::vector<VkPipelineShaderStageCreateInfo>&& shaders) {
@@ -0,0 +1,156 @@
+#include "Profiler.hpp"
+
+namespace ezvk {
+void GpuProfiler::Zone::push(double ms) {
+  samples[head] = ms;
+  head          = (head + 1) % WINDOW_SIZE;
+  stats.sampleCount += 1;
+  stats.lastMs = ms;
+
+  u32 count = std::min(stats.sampleCount, WINDOW_SIZE);
+  double sum = 0.0;
+  stats.minMs = samples[0];
+  stats.maxMs = samples[0];
+  for (u32 i = 0; i < count; ++i) {
+    stats.minMs = std::min(stats.minMs, samples[i]);
+    stats.maxMs = std::max(stats.maxMs, samples[i]);
+    sum += samples[i];
+  }
+  stats.avgMs = sum / count;
+}
+
+void GpuProfiler::create(VkDevice device, VkPhysicalDevice gpu,
+                         u32 queueFamilyIndex, u32 frameCount,
+                         u32 maxZonesPerFrame) {
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties(gpu, &properties);
+  m_nsPerTick = properties.limits.timestampPeriod;
+
+  u32 familyCount = 0;
+  vkGetPhysicalDeviceQueueFamilyProperties(gpu, &familyCount, nullptr);
+  std::vector<VkQueueFamilyProperties> families(familyCount);
+  vkGetPhysicalDeviceQueueFamilyProperties(gpu, &familyCount, families.data());
+  assert(queueFamilyIndex < familyCount);
+  u32 validBits = families[queueFamilyIndex].timestampValidBits;
+  assert(validBits != 0);
+  m_tickMask = validBits >= 64 ? ~u64(0) : (u64(1) << validBits) - 1;
+
+  m_maxQueries = maxZonesPerFrame * 2;
+  // [timestamp, availability] pairs
+  m_results.resize(m_maxQueries * 2);
+
+  VkQueryPoolCreateInfo CI{
+      .sType              = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+      .pNext              = nullptr,
+      .flags              = 0,
+      .queryType          = VK_QUERY_TYPE_TIMESTAMP,
+      .queryCount         = m_maxQueries,
+      .pipelineStatistics = 0,
+  };
+  m_frames.resize(frameCount);
+  for (auto& frame : m_frames) {
+    auto result = vkCreateQueryPool(device, &CI, nullptr, &frame.queryPool);
+    assert(result == VK_SUCCESS);
+    frame.zones.reserve(maxZonesPerFrame);
+  }
+  m_openZones.reserve(16);
+}
+
+void GpuProfiler::destroy(VkDevice device) {
+  for (auto& frame : m_frames) {
+    vkDestroyQueryPool(device, frame.queryPool, nullptr);
+  }
+  m_frames.clear();
+}
+
+void GpuProfiler::beginFrame(VkDevice device, VkCommandBuffer cmd,
+                             u32 frameIndex) {
+  m_current           = frameIndex % u32(m_frames.size());
+  FrameQueries& frame = m_frames[m_current];
+  resolve(device, frame);
+
+  vkCmdResetQueryPool(cmd, frame.queryPool, 0, m_maxQueries);
+  frame.queryCount = 0;
+  frame.zones.clear();
+  m_openZones.clear();
+}
+
+void GpuProfiler::beginZone(VkCommandBuffer cmd, ccstr name) {
+  FrameQueries& frame = m_frames[m_current];
+  if (frame.queryCount + 2 > m_maxQueries) {
+    // out of queries, the zone is silently dropped for this frame
+    m_openZones.push_back(UINT32_MAX);
+    return;
+  }
+  u32 query = frame.queryCount;
+  frame.queryCount += 2;
+  m_openZones.push_back(u32(frame.zones.size()));
+  frame.zones.push_back({zoneId(name), query, query + 1});
+  vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame.queryPool,
+                      query);
+}
+
+void GpuProfiler::endZone(VkCommandBuffer cmd) {
+  assert(!m_openZones.empty());
+  u32 index = m_openZones.back();
+  m_openZones.pop_back();
+  if (index == UINT32_MAX) {
+    return;
+  }
+  FrameQueries& frame = m_frames[m_current];
+  vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                      frame.queryPool, frame.zones[index].endQuery);
+}
+
+void GpuProfiler::resolve(VkDevice device, FrameQueries& frame) {
+  if (frame.queryCount == 0) {
+    return;
+  }
+  // no WAIT_BIT: VK_NOT_READY only means some zones are not available yet,
+  // those are skipped through the availability word
+  auto result = vkGetQueryPoolResults(
+      device, frame.queryPool, 0, frame.queryCount,
+      frame.queryCount * 2 * sizeof(u64), m_results.data(), 2 * sizeof(u64),
+      VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+  if (result != VK_SUCCESS && result != VK_NOT_READY) {
+    return;
+  }
+  for (auto const& zone : frame.zones) {
+    u64 const* begin = &m_results[zone.beginQuery * 2];
+    u64 const* end   = &m_results[zone.endQuery * 2];
+    if (begin[1] == 0 || end[1] == 0) {
+      continue;
+    }
+    u64 ticks = (end[0] - begin[0]) & m_tickMask;
+    m_zones[zone.zoneId].push(double(ticks) * m_nsPerTick * 1e-6);
+  }
+}
+
+u32 GpuProfiler::zoneId(ccstr name) {
+  if (auto it = m_zoneIds.find(name); it != m_zoneIds.end()) {
+    return it->second;
+  }
+  u32 id = u32(m_zones.size());
+  m_zones.push_back({.name = name});
+  m_zoneIds.emplace(name, id);
+  return id;
+}
+
+std::optional<GpuProfiler::ZoneStats>
+GpuProfiler::zoneStats(std::string const& name) const {
+  if (auto it = m_zoneIds.find(name); it != m_zoneIds.end()) {
+    return m_zones[it->second].stats;
+  }
+  return std::nullopt;
+}
+
+std::vector<std::pair<std::string, GpuProfiler::ZoneStats>>
+GpuProfiler::allZoneStats() const {
+  std::vector<std::pair<std::string, ZoneStats>> ret;
+  ret.reserve(m_zones.size());
+  for (auto const& zone : m_zones) {
+    ret.emplace_back(zone.name, zone.stats);
+  }
+  return ret;
+}
+} // namespace ezvk
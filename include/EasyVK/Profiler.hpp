@@ -0,0 +1,85 @@
+#pragma once
+#include "common.hpp"
+
+#include "Command.hpp"
+
+#include <string>
+#include <unordered_map>
+
+namespace ezvk {
+// Timestamp-query profiler with one query pool per frame in flight. Results
+// of a frame are read back without waiting the next time its slot is reused,
+// so beginFrame() must only be called after that frame's fence has signaled.
+class GpuProfiler {
+public:
+  static constexpr u32 WINDOW_SIZE = 64;
+
+  struct ZoneStats {
+    double minMs{0.0};
+    double avgMs{0.0};
+    double maxMs{0.0};
+    double lastMs{0.0};
+    u32    sampleCount{0};
+  };
+
+  void create(VkDevice device, VkPhysicalDevice gpu, u32 queueFamilyIndex,
+              u32 frameCount, u32 maxZonesPerFrame = 128);
+  void destroy(VkDevice device);
+
+  // must be recorded outside of a render pass
+  void beginFrame(VkDevice device, VkCommandBuffer cmd, u32 frameIndex);
+
+  void beginZone(VkCommandBuffer cmd, ccstr name);
+  void endZone(VkCommandBuffer cmd);
+
+  [[nodiscard]] std::optional<ZoneStats>
+  zoneStats(std::string const& name) const;
+  [[nodiscard]] std::vector<std::pair<std::string, ZoneStats>>
+  allZoneStats() const;
+
+private:
+  struct Zone {
+    std::string name;
+    double      samples[WINDOW_SIZE];
+    u32         head{0};
+    ZoneStats   stats;
+
+    void push(double ms);
+  };
+  struct PendingZone {
+    u32 zoneId;
+    u32 beginQuery;
+    u32 endQuery;
+  };
+  struct FrameQueries {
+    VkQueryPool              queryPool;
+    u32                      queryCount{0};
+    std::vector<PendingZone> zones;
+  };
+
+  void resolve(VkDevice device, FrameQueries& frame);
+  u32  zoneId(ccstr name);
+
+  std::vector<FrameQueries>            m_frames;
+  std::vector<Zone>                    m_zones;
+  std::unordered_map<std::string, u32> m_zoneIds;
+  std::vector<u32>                     m_openZones;
+  std::vector<u64>                     m_results;
+
+  u32    m_current{0};
+  u32    m_maxQueries{0};
+  double m_nsPerTick{1.0};
+  u64    m_tickMask{~u64(0)};
+};
+
+struct ScopedZone {
+  CommandBuffer& cmd;
+
+  ScopedZone(CommandBuffer& cmd, ccstr name) : cmd(cmd) {
+    cmd.beginZone(name);
+  }
+  ~ScopedZone() {
+    cmd.endZone();
+  }
+};
+} // namespace ezvk
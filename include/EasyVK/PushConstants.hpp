@@ -0,0 +1,56 @@
+#pragma once
+#include "common.hpp"
+
+#include <type_traits>
+
+namespace ezvk {
+// maxPushConstantsSize guaranteed by the spec
+constexpr u32 MIN_PUSH_CONSTANT_SIZE = 128;
+
+// Compile-time description of a push-constant block. T may declare
+//   static constexpr VkShaderStageFlags pushStages = ...;
+//   static constexpr u32                pushOffset = ...;
+// and otherwise defaults to all stages at offset 0. Vulkan forbids two ranges
+// of one pipeline layout from sharing a stage, so only a layout with a single
+// block can rely on the all-stages default.
+template <typename T>
+struct PushConstants {
+  static constexpr VkShaderStageFlags stages = [] {
+    if constexpr (requires { T::pushStages; }) {
+      return VkShaderStageFlags(T::pushStages);
+    } else {
+      return VkShaderStageFlags(VK_SHADER_STAGE_ALL);
+    }
+  }();
+  static constexpr u32 offset = [] {
+    if constexpr (requires { T::pushOffset; }) {
+      return u32(T::pushOffset);
+    } else {
+      return u32(0);
+    }
+  }();
+  static constexpr u32 size = u32(sizeof(T));
+
+  static_assert(std::is_trivially_copyable_v<T> &&
+                    std::is_standard_layout_v<T>,
+                "push constants are copied byte-wise");
+  static_assert(offset % 4 == 0, "push constant offset must be 4-aligned");
+  static_assert(size % 4 == 0, "push constant size must be a multiple of 4");
+  static_assert(offset + size <= MIN_PUSH_CONSTANT_SIZE,
+                "push constants exceed the guaranteed 128 bytes");
+
+  static constexpr VkPushConstantRange range() {
+    return {stages, offset, size};
+  }
+};
+
+template <typename... Blocks>
+constexpr bool pushStagesDisjoint() {
+  VkShaderStageFlags seen     = 0;
+  bool               disjoint = true;
+  ((disjoint = disjoint && (seen & PushConstants<Blocks>::stages) == 0,
+    seen |= PushConstants<Blocks>::stages),
+   ...);
+  return disjoint;
+}
+} // namespace ezvk
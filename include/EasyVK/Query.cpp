@@ -0,0 +1,87 @@
+#include "Query.hpp"
+
+#include <bit>
+
+namespace ezvk {
+void QueryPool::create(VkDevice device, VkQueryType type, u32 queryCount,
+                       VkQueryPipelineStatisticFlags statistics) {
+  this->type       = type;
+  this->queryCount = queryCount;
+  this->statistics =
+      type == VK_QUERY_TYPE_PIPELINE_STATISTICS ? statistics : 0;
+
+  VkQueryPoolCreateInfo CI{
+      .sType              = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+      .pNext              = nullptr,
+      .flags              = 0,
+      .queryType          = type,
+      .queryCount         = queryCount,
+      .pipelineStatistics = this->statistics,
+  };
+  auto result = vkCreateQueryPool(device, &CI, nullptr, &queryPool);
+  assert(result == VK_SUCCESS);
+}
+
+void QueryPool::destroy(VkDevice device) {
+  vkDestroyQueryPool(device, queryPool, nullptr);
+}
+
+u32 QueryPool::valuesPerQuery() const {
+  if (type == VK_QUERY_TYPE_PIPELINE_STATISTICS) {
+    return u32(std::popcount(statistics));
+  }
+  return 1;
+}
+
+VkResult QueryPool::getResults(VkDevice device, u32 firstQuery, u32 count,
+                               u64* pData) const {
+  VkDeviceSize stride = (valuesPerQuery() + 1) * sizeof(u64);
+  return vkGetQueryPoolResults(device, queryPool, firstQuery, count,
+                               count * stride, pData, stride,
+                               VK_QUERY_RESULT_64_BIT |
+                                   VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+}
+
+void QueryPool::recordOcclusionPredicates(CommandBuffer& cmd, u32 firstQuery,
+                                          u32 count, VkBuffer dstBuffer,
+                                          VkDeviceSize dstOffset) {
+  assert(type == VK_QUERY_TYPE_OCCLUSION);
+  // WAIT_BIT only makes the copy wait on the GPU timeline
+  cmd.copyQueryPoolResults(queryPool, firstQuery, count, dstBuffer, dstOffset,
+                           sizeof(u32), VK_QUERY_RESULT_WAIT_BIT);
+
+  VkBufferMemoryBarrier barrier{
+      .sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+      .pNext               = nullptr,
+      .srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT,
+      .dstAccessMask       = VK_ACCESS_CONDITIONAL_RENDERING_READ_BIT_EXT,
+      .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .buffer              = dstBuffer,
+      .offset              = dstOffset,
+      .size                = count * sizeof(u32),
+  };
+  cmd.pipelineBufferBarrier(VK_PIPELINE_STAGE_TRANSFER_BIT,
+                            VK_PIPELINE_STAGE_CONDITIONAL_RENDERING_BIT_EXT, 0,
+                            1, &barrier);
+}
+
+PipelineStatistics
+PipelineStatistics::decode(VkQueryPipelineStatisticFlags statistics,
+                           u64 const*                    pValues) {
+  PipelineStatistics ret;
+  for (u32 counter = 0; counter < CounterCount; ++counter) {
+    if (statistics & (1u << counter)) {
+      ret.counters[counter] = *pValues++;
+    }
+  }
+  return ret;
+}
+
+void ConditionalRendering::load(VkDevice device) {
+  fpBegin = reinterpret_cast<PFN_vkCmdBeginConditionalRenderingEXT>(
+      vkGetDeviceProcAddr(device, "vkCmdBeginConditionalRenderingEXT"));
+  fpEnd = reinterpret_cast<PFN_vkCmdEndConditionalRenderingEXT>(
+      vkGetDeviceProcAddr(device, "vkCmdEndConditionalRenderingEXT"));
+}
+} // namespace ezvk
@@ -0,0 +1,84 @@
+#pragma once
+#include "common.hpp"
+
+#include "Command.hpp"
+
+namespace ezvk {
+struct QueryPool {
+  VkQueryPool                   queryPool;
+  VkQueryType                   type;
+  VkQueryPipelineStatisticFlags statistics{0};
+  u32                           queryCount{0};
+
+  void create(VkDevice device, VkQueryType type, u32 queryCount,
+              VkQueryPipelineStatisticFlags statistics = 0);
+  void createOcclusion(VkDevice device, u32 queryCount) {
+    create(device, VK_QUERY_TYPE_OCCLUSION, queryCount);
+  }
+  void createPipelineStatistics(VkDevice device, u32 queryCount,
+                                VkQueryPipelineStatisticFlags statistics) {
+    create(device, VK_QUERY_TYPE_PIPELINE_STATISTICS, queryCount, statistics);
+  }
+  void destroy(VkDevice device);
+
+  // number of u64 written per query, not counting the availability word
+  u32 valuesPerQuery() const;
+
+  // Non-blocking readback. pData receives (valuesPerQuery() + 1) u64 per
+  // query, the last one being the availability word. Returns VK_NOT_READY if
+  // at least one query has not finished yet.
+  VkResult getResults(VkDevice device, u32 firstQuery, u32 count,
+                      u64* pData) const;
+  VkResult getResults(VkDevice device, u32 firstQuery, u32 count,
+                      std::vector<u64>& results) const {
+    results.resize(size_t(count) * (valuesPerQuery() + 1));
+    return getResults(device, firstQuery, count, results.data());
+  }
+
+  // Copies occlusion results as 32-bit predicates into `dstBuffer` and makes
+  // them visible to conditional rendering, entirely on the GPU.
+  void recordOcclusionPredicates(CommandBuffer& cmd, u32 firstQuery, u32 count,
+                                 VkBuffer dstBuffer, VkDeviceSize dstOffset);
+
+  EZVK_CONVERT_OP(VkQueryPool, queryPool);
+};
+
+struct PipelineStatistics {
+  enum Counter : u32 {
+    InputAssemblyVertices,
+    InputAssemblyPrimitives,
+    VertexShaderInvocations,
+    GeometryShaderInvocations,
+    GeometryShaderPrimitives,
+    ClippingInvocations,
+    ClippingPrimitives,
+    FragmentShaderInvocations,
+    TessellationControlPatches,
+    TessellationEvaluationInvocations,
+    ComputeShaderInvocations,
+    CounterCount,
+  };
+
+  // counters not enabled in the pool stay at zero
+  u64 counters[CounterCount]{};
+
+  u64 operator[](Counter counter) const {
+    return counters[counter];
+  }
+
+  // `pValues` points at one query's values, in the order Vulkan writes them
+  static PipelineStatistics decode(VkQueryPipelineStatisticFlags statistics,
+                                   u64 const*                    pValues);
+};
+
+struct ConditionalRendering {
+  PFN_vkCmdBeginConditionalRenderingEXT fpBegin{nullptr};
+  PFN_vkCmdEndConditionalRenderingEXT   fpEnd{nullptr};
+
+  // requires VK_EXT_conditional_rendering to be enabled on the device
+  void load(VkDevice device);
+  bool supported() const {
+    return fpBegin != nullptr && fpEnd != nullptr;
+  }
+};
+} // namespace ezvk
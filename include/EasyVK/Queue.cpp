@@ -0,0 +1,114 @@
+#include "Queue.hpp"
+
+namespace ezvk {
+void Queue::create(VkDevice device, VkQueue queue, u32 familyIndex,
+                   Synchronization2 const& sync2) {
+  assert(sync2.supported());
+  this->queue       = queue;
+  this->familyIndex = familyIndex;
+  m_sync2           = sync2;
+
+  timeline.create(device, 0);
+  m_nextValue = 1;
+}
+
+void Queue::create(vkb::Device& device, vkb::QueueType type,
+                   Synchronization2 const& sync2) {
+  auto queueRes = device.get_queue(type);
+  auto indexRes = device.get_queue_index(type);
+  assert(queueRes.has_value() && indexRes.has_value());
+  create(device.device, queueRes.value(), indexRes.value(), sync2);
+}
+
+void Queue::destroy(VkDevice device) {
+  timeline.destroy(device);
+}
+
+u64 Queue::submit(VkCommandBuffer                         cmd,
+                  std::span<const VkSemaphoreSubmitInfo> waits,
+                  std::span<const VkSemaphoreSubmitInfo> signals) {
+  std::lock_guard lock{m_mutex};
+  u64             value = m_nextValue++;
+
+  m_batches.push_back({
+      .cmdIndex    = u32(m_cmds.size()),
+      .firstWait   = u32(m_waits.size()),
+      .waitCount   = u32(waits.size()),
+      .firstSignal = u32(m_signals.size()),
+      .signalCount = u32(signals.size()) + 1,
+  });
+  m_cmds.push_back({
+      .sType         = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
+      .pNext         = nullptr,
+      .commandBuffer = cmd,
+      .deviceMask    = 0,
+  });
+  m_waits.insert(m_waits.end(), waits.begin(), waits.end());
+  m_signals.insert(m_signals.end(), signals.begin(), signals.end());
+  m_signals.push_back(
+      semaphoreInfo(timeline, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, value));
+  return value;
+}
+
+VkResult Queue::flush(VkFence fence) {
+  std::lock_guard lock{m_mutex};
+  if (m_batches.empty() && fence == VK_NULL_HANDLE) {
+    return VK_SUCCESS;
+  }
+
+  // the arrays are complete now, so the pointers below stay valid
+  m_submitInfos.clear();
+  for (auto const& batch : m_batches) {
+    m_submitInfos.push_back({
+        .sType                    = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+        .pNext                    = nullptr,
+        .flags                    = 0,
+        .waitSemaphoreInfoCount   = batch.waitCount,
+        .pWaitSemaphoreInfos      = m_waits.data() + batch.firstWait,
+        .commandBufferInfoCount   = 1,
+        .pCommandBufferInfos      = m_cmds.data() + batch.cmdIndex,
+        .signalSemaphoreInfoCount = batch.signalCount,
+        .pSignalSemaphoreInfos    = m_signals.data() + batch.firstSignal,
+    });
+  }
+  auto result = m_sync2.fpQueueSubmit2(queue, u32(m_submitInfos.size()),
+                                       m_submitInfos.data(), fence);
+
+  m_batches.clear();
+  m_cmds.clear();
+  m_waits.clear();
+  m_signals.clear();
+  return result;
+}
+
+VkSemaphoreSubmitInfo Queue::dependency(u64                   value,
+                                        VkPipelineStageFlags2 stage) {
+  return semaphoreInfo(timeline, stage, value);
+}
+
+u64 Queue::lastSubmitted() {
+  std::lock_guard lock{m_mutex};
+  return m_nextValue - 1;
+}
+
+u64 Queue::completedValue(VkDevice device) {
+  return timeline.currentValue(device);
+}
+
+VkResult Queue::wait(VkDevice device, u64 value, u64 timeout) {
+  return timeline.wait(device, value, timeout);
+}
+
+VkSemaphoreSubmitInfo Queue::semaphoreInfo(VkSemaphore           semaphore,
+                                           VkPipelineStageFlags2 stage,
+                                           u64                   value) {
+  return {
+      .sType       = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+      .pNext       = nullptr,
+      .semaphore   = semaphore,
+      .value       = value,
+      .stageMask   = stage,
+      .deviceIndex = 0,
+  };
+}
+} // namespace ezvk
@@ -0,0 +1,72 @@
+#pragma once
+#include "common.hpp"
+
+#include "Extensions.hpp"
+#include "SyncStructures.hpp"
+
+#include <mutex>
+#include <span>
+
+namespace ezvk {
+// Accumulates command buffers with their semaphores and flushes them in one
+// vkQueueSubmit2KHR (VK_KHR_synchronization2). Every submit() becomes its
+// own batch that signals the next value of the queue's timeline semaphore,
+// which other batches, on this or other queues, can wait on.
+// All members are safe to call from several threads.
+class Queue {
+public:
+  VkQueue           queue;
+  u32               familyIndex;
+  TimelineSemaphore timeline;
+
+  // `sync2` must be loaded, and the device created with
+  // TimelineSemaphore::requiredFeatures()
+  void create(VkDevice device, VkQueue queue, u32 familyIndex,
+              Synchronization2 const& sync2);
+  void create(vkb::Device& device, vkb::QueueType type,
+              Synchronization2 const& sync2);
+  void destroy(VkDevice device);
+
+  // returns the timeline value signaled once `cmd` has completed
+  u64 submit(VkCommandBuffer                         cmd,
+             std::span<const VkSemaphoreSubmitInfo> waits   = {},
+             std::span<const VkSemaphoreSubmitInfo> signals = {});
+  VkResult flush(VkFence fence = VK_NULL_HANDLE);
+
+  // wait info on this queue's timeline, to pass to another submit()
+  VkSemaphoreSubmitInfo dependency(u64 value, VkPipelineStageFlags2 stage);
+
+  // highest value handed out by submit(), flushed or not
+  u64 lastSubmitted();
+  u64 completedValue(VkDevice device);
+  VkResult wait(VkDevice device, u64 value,
+                u64 timeout = TimelineSemaphore::NO_TIMEOUT);
+
+  // the entry points this queue was created with
+  Synchronization2 const& sync2() const {
+    return m_sync2;
+  }
+
+  static VkSemaphoreSubmitInfo semaphoreInfo(VkSemaphore           semaphore,
+                                             VkPipelineStageFlags2 stage,
+                                             u64                   value = 0);
+
+  EZVK_CONVERT_OP(VkQueue, queue);
+
+private:
+  struct Batch {
+    u32 cmdIndex;
+    u32 firstWait, waitCount;
+    u32 firstSignal, signalCount;
+  };
+
+  Synchronization2                       m_sync2;
+  std::mutex                             m_mutex;
+  std::vector<Batch>                     m_batches;
+  std::vector<VkCommandBufferSubmitInfo> m_cmds;
+  std::vector<VkSemaphoreSubmitInfo>     m_waits;
+  std::vector<VkSemaphoreSubmitInfo>     m_signals;
+  std::vector<VkSubmitInfo2>             m_submitInfos;
+  u64                                    m_nextValue{1};
+};
+} // namespace ezvk
@@ -4,15 +4,31 @@
 namespace ezvk {
 
 void Swapchain::create(vkb::Device* device, VkSurfaceKHR surface, u32 width,
-                       u32 height) {
-  vkb::SwapchainBuilder builder{*device, surface};
+                       u32                                  height,
+                       std::vector<VkPresentModeKHR> const& presentModes,
+                       u32                                  minImageCount) {
+  m_device        = device;
+  m_surface       = surface;
+  m_presentModes  = presentModes;
+  m_minImageCount = minImageCount;
+  build(width, height, VK_NULL_HANDLE);
+}
+
+void Swapchain::build(u32 width, u32 height, VkSwapchainKHR oldSwapchain) {
+  vkb::SwapchainBuilder builder{*m_device, m_surface};
 
-  auto result =
-      builder.use_default_format_selection()
-          .set_desired_present_mode(VK_PRESENT_MODE_FIFO_KHR)
-          .set_desired_extent(width, height)
-          // .set_image_usage_flags(VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT)
-          .build();
+  builder.use_default_format_selection()
+      .set_desired_extent(width, height)
+      .set_old_swapchain(oldSwapchain);
+  // .set_image_usage_flags(VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT)
+  // vk-bootstrap picks the first supported mode and falls back to FIFO
+  for (auto mode : m_presentModes) {
+    builder.add_fallback_present_mode(mode);
+  }
+  if (m_minImageCount != 0) {
+    builder.set_desired_min_image_count(m_minImageCount);
+  }
+  auto result = builder.build();
 
   assert(result.has_value());
   m_swapchain  = (result.value());
@@ -20,8 +36,29 @@ void Swapchain::create(vkb::Device* device, VkSurfaceKHR surface, u32 width,
   m_imageViews = std::move(m_swapchain.get_image_views().value());
 }
 
+// The old swapchain is retired rather than destroyed: frames still in flight
+// may present or sample from its images, and handing it to the new one lets
+// the presentation engine move over without a device idle.
+void Swapchain::recreate(u32 width, u32 height, u64 frameIndex) {
+  m_retired.push_back({m_swapchain, std::move(m_imageViews), frameIndex});
+  build(width, height, m_retired.back().swapchain);
+  ++generation;
+}
+
+void Swapchain::collectRetired(u64 completedFrame) {
+  std::erase_if(m_retired, [completedFrame](Retired& retired) {
+    if (retired.frameIndex > completedFrame) {
+      return false;
+    }
+    retired.swapchain.destroy_image_views(retired.imageViews);
+    vkb::destroy_swapchain(retired.swapchain);
+    return true;
+  });
+}
+
 void Swapchain::destroy() {
+  collectRetired(std::numeric_limits<u64>::max());
   m_swapchain.destroy_image_views(m_imageViews);
   vkb::destroy_swapchain(m_swapchain);
 }
-} // namespace ezvk
\ No newline at end of file
+} // namespace ezvk
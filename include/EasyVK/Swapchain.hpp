@@ -1,6 +1,8 @@
 #pragma once
 #include "common.hpp"
 
+#include <limits>
+
 namespace ezvk {
 class Device;
 class Swapchain {
@@ -9,13 +11,47 @@ public:
 
   std::vector<VkImage>     m_images;
   std::vector<VkImageView> m_imageViews;
+  // bumped by recreate(), so dependents can rebuild lazily
+  u64                      generation{0};
 
-  void create(vkb::Device* device, VkSurfaceKHR surface, u32 width, u32 height);
+  // `presentModes` in order of preference; FIFO, the only mode every device
+  // supports, is the final fallback. MAILBOX and IMMEDIATE cut latency,
+  // FIFO_RELAXED tears only when a frame misses vblank. A `minImageCount` of
+  // 0 keeps the driver minimum plus one.
+  void create(vkb::Device* device, VkSurfaceKHR surface, u32 width, u32 height,
+              std::vector<VkPresentModeKHR> const& presentModes =
+                  {VK_PRESENT_MODE_FIFO_KHR},
+              u32 minImageCount = 0);
+  // Builds a new swapchain from the current one without waiting for the
+  // device. The old swapchain and its views are kept until
+  // collectRetired() reports `frameIndex`, the last frame that may still
+  // use them, as complete.
+  void recreate(u32 width, u32 height, u64 frameIndex);
+  void collectRetired(u64 completedFrame);
+  // the device must be idle
   void destroy();
   u32  getImageCount() {
      return m_swapchain.image_count;
   }
+  VkPresentModeKHR getPresentMode() {
+    return m_swapchain.present_mode;
+  }
 
   EZVK_CONVERT_OP(VkSwapchainKHR, m_swapchain);
+
+private:
+  struct Retired {
+    vkb::Swapchain           swapchain;
+    std::vector<VkImageView> imageViews;
+    u64                      frameIndex;
+  };
+
+  void build(u32 width, u32 height, VkSwapchainKHR oldSwapchain);
+
+  vkb::Device*                  m_device;
+  VkSurfaceKHR                  m_surface;
+  std::vector<VkPresentModeKHR> m_presentModes;
+  u32                           m_minImageCount;
+  std::vector<Retired>          m_retired;
 };
 } // namespace ezvk
\ No newline at end of file
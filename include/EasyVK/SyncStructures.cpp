@@ -36,4 +36,97 @@ void Semaphore::destroy(VkDevice device) {
   vkDestroySemaphore(device, semaphore, nullptr);
 }
 
+VkPhysicalDeviceVulkan12Features TimelineSemaphore::requiredFeatures() {
+  return {
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+      .pNext = nullptr,
+      .timelineSemaphore = VK_TRUE,
+  };
+}
+
+void TimelineSemaphore::create(VkDevice device, u64 initialValue) {
+  VkSemaphoreTypeCreateInfo typeCI{
+      .sType         = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+      .pNext         = nullptr,
+      .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+      .initialValue  = initialValue,
+  };
+  VkSemaphoreCreateInfo CI{
+      .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+      .pNext = &typeCI,
+      .flags = 0,
+  };
+  auto result = vkCreateSemaphore(device, &CI, nullptr, &semaphore);
+  assert(result == VK_SUCCESS);
+}
+
+void TimelineSemaphore::destroy(VkDevice device) {
+  vkDestroySemaphore(device, semaphore, nullptr);
+}
+
+VkResult TimelineSemaphore::signal(VkDevice device, u64 value) {
+  VkSemaphoreSignalInfo SI{
+      .sType     = VK_STRUCTURE_TYPE_SEMAPHORE_SIGNAL_INFO,
+      .pNext     = nullptr,
+      .semaphore = semaphore,
+      .value     = value,
+  };
+  return vkSignalSemaphore(device, &SI);
+}
+
+VkResult TimelineSemaphore::wait(VkDevice device, u64 value, u64 timeout) {
+  VkSemaphoreWaitInfo WI{
+      .sType          = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+      .pNext          = nullptr,
+      .flags          = 0,
+      .semaphoreCount = 1,
+      .pSemaphores    = &semaphore,
+      .pValues        = &value,
+  };
+  return vkWaitSemaphores(device, &WI, timeout);
+}
+
+u64 TimelineSemaphore::currentValue(VkDevice device) {
+  u64  value  = 0;
+  auto result = vkGetSemaphoreCounterValue(device, semaphore, &value);
+  assert(result == VK_SUCCESS);
+  return value;
+}
+
+VkResult TimelineSemaphore::waitAll(VkDevice                     device,
+                                    std::span<TimelineSemaphore> semaphores,
+                                    std::span<const u64>         values,
+                                    u64                          timeout) {
+  return waitMany(device, 0, semaphores, values, timeout);
+}
+
+VkResult TimelineSemaphore::waitAny(VkDevice                     device,
+                                    std::span<TimelineSemaphore> semaphores,
+                                    std::span<const u64>         values,
+                                    u64                          timeout) {
+  return waitMany(device, VK_SEMAPHORE_WAIT_ANY_BIT, semaphores, values,
+                  timeout);
+}
+
+VkResult TimelineSemaphore::waitMany(VkDevice                     device,
+                                     VkSemaphoreWaitFlags         flags,
+                                     std::span<TimelineSemaphore> semaphores,
+                                     std::span<const u64>         values,
+                                     u64                          timeout) {
+  assert(semaphores.size() == values.size());
+  std::vector<VkSemaphore> handles;
+  handles.reserve(semaphores.size());
+  for (auto const& timeline : semaphores) {
+    handles.push_back(timeline.semaphore);
+  }
+  VkSemaphoreWaitInfo WI{
+      .sType          = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+      .pNext          = nullptr,
+      .flags          = flags,
+      .semaphoreCount = u32(handles.size()),
+      .pSemaphores    = handles.data(),
+      .pValues        = values.data(),
+  };
+  return vkWaitSemaphores(device, &WI, timeout);
+}
 } // namespace ezvk
\ No newline at end of file
@@ -1,6 +1,9 @@
 #pragma once
 #include "common.hpp"
 
+#include <limits>
+#include <span>
+
 namespace ezvk {
 struct Fence {
   VkFence fence;
@@ -22,4 +25,44 @@ struct Semaphore {
   EZVK_CONVERT_OP(VkSemaphore, semaphore);
   EZVK_ADDRESS_OP(VkSemaphore, semaphore);
 };
+// Vulkan 1.2 timeline semaphore: one monotonically increasing counter that
+// both the host and queues can signal and wait on, so a single semaphore per
+// queue replaces a fence per submission. The device must be created with the
+// timelineSemaphore feature, see requiredFeatures(); Queue, GpuExecutor,
+// AsyncCompute and TransferStream all build on it.
+struct TimelineSemaphore {
+  static constexpr u64 NO_TIMEOUT = std::numeric_limits<u64>::max();
+
+  // merge into Features12 (Extensions.hpp) before creating the device
+  static VkPhysicalDeviceVulkan12Features requiredFeatures();
+
+  VkSemaphore semaphore;
+
+  void create(VkDevice device, u64 initialValue = 0);
+  void destroy(VkDevice device);
+
+  // host-side signal; `value` must be greater than the current value
+  VkResult signal(VkDevice device, u64 value);
+  // VK_TIMEOUT if `value` was not reached in time, a timeout of 0 polls
+  VkResult wait(VkDevice device, u64 value, u64 timeout = NO_TIMEOUT);
+  u64      currentValue(VkDevice device);
+
+  // semaphores[i] is waited for up to values[i]
+  static VkResult waitAll(VkDevice device,
+                          std::span<TimelineSemaphore> semaphores,
+                          std::span<const u64>         values,
+                          u64                          timeout = NO_TIMEOUT);
+  static VkResult waitAny(VkDevice device,
+                          std::span<TimelineSemaphore> semaphores,
+                          std::span<const u64>         values,
+                          u64                          timeout = NO_TIMEOUT);
+
+  EZVK_CONVERT_OP(VkSemaphore, semaphore);
+  EZVK_ADDRESS_OP(VkSemaphore, semaphore);
+
+private:
+  static VkResult waitMany(VkDevice device, VkSemaphoreWaitFlags flags,
+                           std::span<TimelineSemaphore> semaphores,
+                           std::span<const u64> values, u64 timeout);
+};
 } // namespace ezvk
\ No newline at end of file
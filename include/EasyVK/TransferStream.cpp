@@ -0,0 +1,229 @@
+#include "TransferStream.hpp"
+
+namespace ezvk {
+/*
+  StagingRing
+ */
+
+void StagingRing::create(VkDeviceSize capacity, VkDeviceSize alignment) {
+  assert((alignment & (alignment - 1)) == 0);
+  m_capacity  = capacity;
+  m_alignment = alignment;
+  m_head      = 0;
+  m_used      = 0;
+}
+
+std::optional<StagingRing::Allocation>
+StagingRing::allocate(VkDeviceSize size) {
+  assert(size <= m_capacity);
+  if (m_used == 0) {
+    m_head = 0;
+  }
+
+  VkDeviceSize offset  = (m_head + m_alignment - 1) & ~(m_alignment - 1);
+  VkDeviceSize charged = offset - m_head + size;
+  if (offset + size > m_capacity) {
+    offset  = 0;
+    charged = m_capacity - m_head + size;
+  }
+  if (m_used + charged > m_capacity) {
+    return std::nullopt;
+  }
+
+  m_head = offset + size;
+  m_used += charged;
+  return Allocation{offset, charged};
+}
+
+void StagingRing::release(VkDeviceSize charged) {
+  assert(charged <= m_used);
+  m_used -= charged;
+}
+
+/*
+  TransferStream
+ */
+
+void TransferStream::create(VkDevice device, BufferAllocator& allocator,
+                            Queue* transfer, u32 consumerFamily,
+                            VkDeviceSize stagingSize) {
+  m_transfer       = transfer;
+  m_consumerFamily = consumerFamily;
+  m_allocator      = &allocator;
+  m_cmdPool.create(device, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+                   transfer->familyIndex);
+
+  VkBufferCreateInfo CI{
+      .sType                 = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+      .pNext                 = nullptr,
+      .flags                 = 0,
+      .size                  = stagingSize,
+      .usage                 = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+      .sharingMode           = VK_SHARING_MODE_EXCLUSIVE,
+      .queueFamilyIndexCount = 0,
+      .pQueueFamilyIndices   = nullptr,
+  };
+  VmaAllocationCreateInfo AI{
+      .flags = VMA_ALLOCATION_CREATE_MAPPED_BIT |
+               VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT,
+      .usage = VMA_MEMORY_USAGE_AUTO,
+  };
+  VmaAllocationInfo info;
+  m_staging = allocator.createBuffer(&CI, &AI, &info);
+  m_mapped  = static_cast<u8*>(info.pMappedData);
+  assert(m_mapped != nullptr);
+
+  m_ring.create(stagingSize, STAGING_ALIGNMENT);
+  m_pending = {transfer->familyIndex, consumerFamily};
+}
+
+void TransferStream::destroy(VkDevice device, BufferAllocator& allocator) {
+  if (!m_inFlight.empty()) {
+    m_transfer->wait(device, m_inFlight.back().value);
+  }
+  collect(device);
+  if (m_current.has_value()) {
+    m_current->cmd.free(device, m_cmdPool);
+    m_current.reset();
+  }
+  for (auto& cmd : m_freeCmds) {
+    cmd.free(device, m_cmdPool);
+  }
+  m_freeCmds.clear();
+  m_cmdPool.destroy(device);
+  allocator.destroyBuffer(m_staging);
+}
+
+std::optional<VkDeviceSize> TransferStream::reserve(VkDevice     device,
+                                                    VkDeviceSize size) {
+  auto allocation = m_ring.allocate(size);
+  while (!allocation.has_value()) {
+    collect(device);
+    allocation = m_ring.allocate(size);
+    if (allocation.has_value()) {
+      break;
+    }
+    if (m_inFlight.empty()) {
+      return std::nullopt;
+    }
+    m_transfer->wait(device, m_inFlight.front().value);
+  }
+
+  currentCmd(device);
+  m_current->consumed += allocation->charged;
+  return allocation->offset;
+}
+
+CommandBuffer& TransferStream::currentCmd(VkDevice device) {
+  if (!m_current.has_value()) {
+    m_current.emplace();
+    if (m_freeCmds.empty()) {
+      m_current->cmd.alloc(device, m_cmdPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+    } else {
+      m_current->cmd = m_freeCmds.back();
+      m_freeCmds.pop_back();
+    }
+    m_current->cmd.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+  }
+  return m_current->cmd;
+}
+
+bool TransferStream::uploadBuffer(VkDevice device, VkBuffer dstBuffer,
+                                  VkDeviceSize dstOffset, const void* data,
+                                  VkDeviceSize size,
+                                  VkPipelineStageFlags2 dstStage,
+                                  VkAccessFlags2        dstAccess) {
+  auto offset = reserve(device, size);
+  if (!offset.has_value()) {
+    return false;
+  }
+  memcpy(m_mapped + *offset, data, size);
+  vmaFlushAllocation(m_allocator->m_allocator, m_staging.allocation, *offset,
+                     size);
+
+  VkBufferCopy region{
+      .srcOffset = *offset,
+      .dstOffset = dstOffset,
+      .size      = size,
+  };
+  m_current->cmd.copyBuffer(m_staging.buffer, dstBuffer, 1, &region);
+  m_pending.addBuffer(dstBuffer, VK_PIPELINE_STAGE_2_COPY_BIT,
+                      VK_ACCESS_2_TRANSFER_WRITE_BIT, dstStage, dstAccess,
+                      dstOffset, size);
+  return true;
+}
+
+bool TransferStream::uploadImage(VkDevice device, VkImage dstImage,
+                                 VkBufferImageCopy       region,
+                                 VkImageSubresourceRange range,
+                                 VkImageLayout         finalLayout,
+                                 const void*           data,
+                                 VkDeviceSize          size,
+                                 VkPipelineStageFlags2 dstStage,
+                                 VkAccessFlags2        dstAccess) {
+  auto offset = reserve(device, size);
+  if (!offset.has_value()) {
+    return false;
+  }
+  memcpy(m_mapped + *offset, data, size);
+  vmaFlushAllocation(m_allocator->m_allocator, m_staging.allocation, *offset,
+                     size);
+
+  // the previous contents are discarded, so no ownership is needed here
+  VkImageMemoryBarrier2 toTransfer{
+      .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+      .pNext               = nullptr,
+      .srcStageMask        = VK_PIPELINE_STAGE_2_NONE,
+      .srcAccessMask       = VK_ACCESS_2_NONE,
+      .dstStageMask        = VK_PIPELINE_STAGE_2_COPY_BIT,
+      .dstAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+      .oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED,
+      .newLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+      .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .image               = dstImage,
+      .subresourceRange    = range,
+  };
+  region.bufferOffset = *offset;
+  m_current->cmd
+      .pipelineBarrier2(m_transfer->sync2(), 0, nullptr, 1, &toTransfer)
+      .copyBufferToImage(m_staging.buffer, dstImage,
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+  m_pending.addImage(dstImage, range, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                     finalLayout, VK_PIPELINE_STAGE_2_COPY_BIT,
+                     VK_ACCESS_2_TRANSFER_WRITE_BIT, dstStage, dstAccess);
+  return true;
+}
+
+TransferStream::Ticket TransferStream::flush(VkDevice device) {
+  if (!m_current.has_value()) {
+    return {0, {m_transfer->familyIndex, m_consumerFamily}};
+  }
+  m_pending.recordRelease(m_transfer->sync2(), m_current->cmd);
+  m_current->cmd.end();
+
+  m_current->value = m_transfer->submit(m_current->cmd.cmdBuffer);
+  auto result      = m_transfer->flush();
+  assert(result == VK_SUCCESS);
+
+  Ticket ticket{m_current->value, std::move(m_pending)};
+  m_inFlight.push_back(std::move(*m_current));
+  m_current.reset();
+  m_pending = {m_transfer->familyIndex, m_consumerFamily};
+  return ticket;
+}
+
+void TransferStream::collect(VkDevice device) {
+  if (m_inFlight.empty()) {
+    return;
+  }
+  u64 completed = m_transfer->completedValue(device);
+  while (!m_inFlight.empty() && m_inFlight.front().value <= completed) {
+    auto& batch = m_inFlight.front();
+    m_ring.release(batch.consumed);
+    batch.cmd.reset(0);
+    m_freeCmds.push_back(batch.cmd);
+    m_inFlight.pop_front();
+  }
+}
+} // namespace ezvk
@@ -0,0 +1,109 @@
+#pragma once
+#include "common.hpp"
+
+#include "AsyncCompute.hpp"
+#include "BufferAllocator.hpp"
+#include "Command.hpp"
+#include "Queue.hpp"
+
+#include <deque>
+#include <optional>
+
+namespace ezvk {
+// Offset bookkeeping of a ring buffer, without the Vulkan side. Live
+// allocations form one contiguous run ending at head(), possibly wrapping,
+// so an allocation that does not fit before the end skips the tail and is
+// charged for it. Allocations are released in the order they were made.
+class StagingRing {
+public:
+  struct Allocation {
+    VkDeviceSize offset;
+    // size plus alignment padding or the skipped tail; pass to release()
+    VkDeviceSize charged;
+  };
+
+  void create(VkDeviceSize capacity, VkDeviceSize alignment);
+
+  // nullopt until enough earlier allocations are released
+  std::optional<Allocation> allocate(VkDeviceSize size);
+  void                      release(VkDeviceSize charged);
+
+  VkDeviceSize capacity() const {
+    return m_capacity;
+  }
+  VkDeviceSize used() const {
+    return m_used;
+  }
+  VkDeviceSize head() const {
+    return m_head;
+  }
+
+private:
+  VkDeviceSize m_capacity{0};
+  VkDeviceSize m_alignment{1};
+  VkDeviceSize m_head{0};
+  VkDeviceSize m_used{0};
+};
+
+// Streams uploads through a persistently mapped staging ring on a
+// (preferably transfer-only) queue. Each flush() is one submit signaling the
+// transfer queue's timeline; the consumer waits on that value and records
+// the returned acquire barriers before touching the data.
+class TransferStream {
+public:
+  static constexpr VkDeviceSize STAGING_ALIGNMENT = 16;
+
+  struct Ticket {
+    u64               value; // transfer timeline value, 0 if nothing flushed
+    OwnershipTransfer acquire;
+  };
+
+  void create(VkDevice device, BufferAllocator& allocator, Queue* transfer,
+              u32 consumerFamily, VkDeviceSize stagingSize);
+  void destroy(VkDevice device, BufferAllocator& allocator);
+
+  // Return false if the staging ring is full of unflushed data; flush() and
+  // retry in that case. Space held by in-flight batches is waited for.
+  bool uploadBuffer(VkDevice device, VkBuffer dstBuffer,
+                    VkDeviceSize dstOffset, const void* data,
+                    VkDeviceSize size, VkPipelineStageFlags2 dstStage,
+                    VkAccessFlags2 dstAccess);
+  // `region.bufferOffset` is filled in; the image ends up in `finalLayout`
+  bool uploadImage(VkDevice device, VkImage dstImage, VkBufferImageCopy region,
+                   VkImageSubresourceRange range, VkImageLayout finalLayout,
+                   const void* data, VkDeviceSize size,
+                   VkPipelineStageFlags2 dstStage, VkAccessFlags2 dstAccess);
+
+  Ticket flush(VkDevice device);
+  // wait info for the consumer's submit
+  VkSemaphoreSubmitInfo waitInfo(Ticket const&         ticket,
+                                 VkPipelineStageFlags2 stage) {
+    return m_transfer->dependency(ticket.value, stage);
+  }
+  // recycles staging space and command buffers of completed batches
+  void collect(VkDevice device);
+
+private:
+  struct Batch {
+    CommandBuffer cmd;
+    u64           value{0};
+    VkDeviceSize  consumed{0};
+  };
+
+  std::optional<VkDeviceSize> reserve(VkDevice device, VkDeviceSize size);
+  CommandBuffer&              currentCmd(VkDevice device);
+
+  Queue*           m_transfer;
+  u32              m_consumerFamily;
+  CommandPool      m_cmdPool;
+  AllocatedBuffer  m_staging;
+  BufferAllocator* m_allocator;
+  u8*              m_mapped;
+  StagingRing      m_ring;
+
+  std::optional<Batch>       m_current;
+  std::deque<Batch>          m_inFlight;
+  std::vector<CommandBuffer> m_freeCmds;
+  OwnershipTransfer          m_pending;
+};
+} // namespace ezvk
@@ -0,0 +1,127 @@
+#include <EasyVK/DrawQueue.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// the queue only compares and hashes handles, so any distinct values do
+template <typename Handle>
+Handle fakeHandle(u64 value) {
+  return reinterpret_cast<Handle>(uintptr_t(value));
+}
+
+void check(bool condition, const char* what) {
+  if (!condition) {
+    printf("failed: %s\n", what);
+    exit(-1);
+  }
+}
+
+ezvk::DrawPacket makePacket(u64 pipeline, float depth, u32 indexCount,
+                            u32 firstInstance) {
+  return {
+      .pipeline      = fakeHandle<VkPipeline>(pipeline),
+      .layout        = fakeHandle<VkPipelineLayout>(1),
+      .descriptorSet = fakeHandle<VkDescriptorSet>(1),
+      .vertexBuffer  = fakeHandle<VkBuffer>(1),
+      .indexBuffer   = fakeHandle<VkBuffer>(2),
+      .indexCount    = indexCount,
+      .firstInstance = firstInstance,
+      .depth         = depth,
+  };
+}
+
+void testSortAndBatching() {
+  ezvk::DrawQueue queue;
+  queue.submit(makePacket(1, 1.0f, 36, 0));  // 0
+  queue.submit(makePacket(2, 0.5f, 6, 1));   // 1
+  queue.submit(makePacket(1, 2.0f, 36, 1));  // 2
+  queue.submit(makePacket(2, 0.25f, 6, 0));  // 3
+  queue.submit(makePacket(1, 3.0f, 12, 0));  // 4
+  queue.sort();
+
+  // grouped by pipeline in order of first use, front to back within a group
+  auto            order = queue.order();
+  std::vector<u32> expected{0, 2, 4, 3, 1};
+  check(std::equal(order.begin(), order.end(), expected.begin(),
+                   expected.end()),
+        "sort order");
+
+  std::vector<VkDrawIndexedIndirectCommand> run;
+  check(queue.collectRun(0, run) == 3, "first run ends after pipeline 1");
+  check(run.size() == 2, "first run has two draws");
+  check(run[0].indexCount == 36 && run[0].firstInstance == 0 &&
+            run[0].instanceCount == 2,
+        "consecutive instances merged");
+  check(run[1].indexCount == 12 && run[1].instanceCount == 1,
+        "different geometry kept apart");
+
+  check(queue.collectRun(3, run) == 5, "second run ends at the queue end");
+  check(run.size() == 1 && run[0].instanceCount == 2,
+        "instances merged after sorting by depth");
+}
+
+void testStateBreaksRun() {
+  ezvk::DrawQueue queue;
+  auto            a = makePacket(1, 1.0f, 36, 0);
+  auto            b = makePacket(1, 2.0f, 36, 1);
+  b.materialSet     = fakeHandle<VkDescriptorSet>(7);
+  queue.submit(a);
+  queue.submit(b);
+  queue.sort();
+
+  std::vector<VkDrawIndexedIndirectCommand> run;
+  check(queue.collectRun(0, run) == 1, "material change ends the run");
+  check(run.size() == 1 && run[0].instanceCount == 1,
+        "instances of different materials not merged");
+}
+
+void testLargeSort() {
+  ezvk::DrawQueue    queue;
+  std::vector<float> depths;
+  u32                seed = 1;
+  for (u32 i = 0; i < 4096; ++i) {
+    seed = seed * 1664525 + 1013904223;
+    depths.push_back(float(seed >> 8) / 1024.0f);
+    queue.submit(makePacket(1 + (seed >> 28) % 4, depths.back(), 3, 0));
+  }
+  queue.sort();
+
+  auto order = queue.order();
+  check(order.size() == 4096, "every packet sorted");
+  std::vector<bool> seen(order.size());
+  for (u32 index : order) {
+    check(index < seen.size() && !seen[index], "order is a permutation");
+    seen[index] = true;
+  }
+
+  // packets differ only in pipeline and depth, so each pipeline is one run;
+  // every packet starts at instance 0, so none of them merge
+  std::vector<VkDrawIndexedIndirectCommand> run;
+  u32                                       groups = 0;
+  for (u32 i = 0; i < order.size(); ++groups) {
+    u32 end = queue.collectRun(i, run);
+    check(run.size() == end - i, "one draw per packet");
+    // the key keeps the upper 16 bits of the depth
+    for (u32 j = i + 1; j < end; ++j) {
+      check(std::bit_cast<u32>(depths[order[j - 1]]) >> 16 <=
+                std::bit_cast<u32>(depths[order[j]]) >> 16,
+            "front to back within a run");
+    }
+    i = end;
+  }
+  check(groups == 4, "one run per pipeline");
+
+  queue.clear();
+  queue.sort();
+  check(queue.order().empty(), "clear drops every packet");
+}
+
+int main() {
+  testSortAndBatching();
+  testStateBreaksRun();
+  testLargeSort();
+  puts("DrawQueue: ok");
+}
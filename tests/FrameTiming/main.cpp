@@ -0,0 +1,96 @@
+#include <EasyVK/FrameTiming.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+using Timing = ezvk::FrameTiming;
+
+void check(bool condition, const char* what) {
+  if (!condition) {
+    printf("failed: %s\n", what);
+    exit(-1);
+  }
+}
+
+// GPU times are set directly, so they give exact samples without a device
+void testNearestRank() {
+  auto timing = std::make_unique<Timing>();
+  timing->create();
+  check(timing->interval(Timing::Gpu).sampleCount == 0, "empty window");
+
+  // 1..100, submitted out of order
+  for (u64 i = 0; i < 100; ++i) {
+    timing->beginFrame(i);
+    timing->setGpuTime(i, double(100 - i));
+  }
+  // frames without a GPU time are not samples
+  for (u64 i = 100; i < 110; ++i) {
+    timing->beginFrame(i);
+  }
+  auto gpu = timing->interval(Timing::Gpu);
+  check(gpu.sampleCount == 100, "sample count");
+  check(gpu.p50 == 50.0 && gpu.p95 == 95.0 && gpu.p99 == 99.0,
+        "nearest rank of 1..100");
+
+  timing->create();
+  for (u64 i = 0; i < 3; ++i) {
+    timing->beginFrame(i);
+    timing->setGpuTime(i, double(i + 1));
+  }
+  gpu = timing->interval(Timing::Gpu);
+  check(gpu.p50 == 2.0 && gpu.p95 == 3.0 && gpu.p99 == 3.0,
+        "nearest rank of three samples");
+}
+
+void testWindow() {
+  auto timing = std::make_unique<Timing>();
+  timing->create();
+  for (u64 i = 0; i < 1000; ++i) {
+    timing->beginFrame(i);
+    timing->setGpuTime(i, double(i));
+  }
+  // late results for frames that left the window are dropped
+  timing->setGpuTime(10, 1e9);
+  check(timing->record(10) == nullptr, "old frame left the window");
+  check(timing->record(999) != nullptr, "latest frame kept");
+
+  // samples are 744..999
+  auto gpu = timing->interval(Timing::Gpu);
+  check(gpu.sampleCount == Timing::WINDOW_SIZE, "window size");
+  check(gpu.p50 == 871.0 && gpu.p95 == 987.0 && gpu.p99 == 997.0,
+        "percentiles over the window");
+
+  std::string csv = timing->csv();
+  check(std::count(csv.begin(), csv.end(), '\n') == Timing::WINDOW_SIZE + 1,
+        "one csv line per frame plus header");
+}
+
+void testMarks() {
+  auto timing = std::make_unique<Timing>();
+  timing->create();
+  for (u64 i = 0; i < 4; ++i) {
+    timing->beginFrame(i);
+    timing->mark(Timing::FenceSignaled);
+    timing->mark(Timing::AcquireReturned);
+    timing->mark(Timing::RecordDone);
+  }
+  auto const* last = timing->record(3);
+  check(last != nullptr, "record of the current frame");
+  auto record = timing->intervalOf(*last, Timing::Record);
+  check(record.has_value() && *record >= 0.0, "marked interval");
+  check(!timing->intervalOf(*last, Timing::SubmitCall).has_value(),
+        "unmarked interval");
+  check(!timing->intervalOf(*last, Timing::FrameTime).has_value(),
+        "frame time needs the next frame");
+  check(timing->interval(Timing::FrameTime).sampleCount == 3,
+        "frame time of all but the last frame");
+}
+
+int main() {
+  testNearestRank();
+  testWindow();
+  testMarks();
+  puts("FrameTiming: ok");
+}
@@ -0,0 +1,165 @@
+#include <EasyVK/BufferAllocator.hpp>
+#include <EasyVK/Command.hpp>
+#include <EasyVK/Device.hpp>
+#include <EasyVK/Instance.hpp>
+#include <EasyVK/Offscreen.hpp>
+#include <EasyVK/SyncStructures.hpp>
+
+#include <cstdio>
+
+constexpr u32        FRAME_COUNT = 8;
+constexpr VkExtent2D EXTENT{64, 64};
+
+struct App {
+  ezvk::Instance instance;
+  ezvk::Device   device;
+
+  VkQueue graphicsQueue;
+  u32     graphicsQueueIndex;
+
+  ezvk::BufferAllocator allocator;
+  ezvk::OffscreenTarget target;
+
+  ezvk::CommandPool   cmdPool;
+  ezvk::CommandBuffer cmdBuffers[3];
+  ezvk::Semaphore     renderSemaphores[3];
+  ezvk::Fence         renderFences[3];
+
+  u32 received{0};
+  u32 mismatched{0};
+
+  void init() {
+    instance.create({}, {}, [](vkb::InstanceBuilder& builder) {
+      builder.set_app_name("AppName")
+          .set_headless()
+          .set_engine_name("EngineName")
+          .set_app_version(1)
+          .require_api_version(1, 2);
+    });
+    device.create(instance, [](vkb::PhysicalDeviceSelector& selector) {
+      selector.set_minimum_version(1, 1);
+    });
+    graphicsQueue = device.m_device.get_queue(vkb::QueueType::graphics).value();
+    graphicsQueueIndex =
+        device.m_device.get_queue_index(vkb::QueueType::graphics).value();
+    allocator.create(device.m_gpu, device, instance);
+
+    auto result = target.create(
+        device, allocator, graphicsQueue, graphicsQueueIndex, EXTENT,
+        VK_FORMAT_R8G8B8A8_UNORM, 3, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+    if (result != VK_SUCCESS) {
+      puts("failed to create offscreen target");
+      exit(-1);
+    }
+    target.setConsumer([this](ezvk::OffscreenFrame const& frame) {
+      auto pixels = static_cast<const u8*>(frame.pixels);
+      u8   red    = u8(frame.frameIndex * 16);
+      if (pixels[0] != red || pixels[frame.size - 4] != red) {
+        ++mismatched;
+      }
+      printf("frame %llu: image %u, first pixel %u %u %u %u\n",
+             (unsigned long long)frame.frameIndex, frame.imageIndex, pixels[0],
+             pixels[1], pixels[2], pixels[3]);
+      ++received;
+    });
+
+    cmdPool.create(device, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+                   graphicsQueueIndex);
+    for (u32 i = 0; i < 3; ++i) {
+      cmdBuffers[i].alloc(device, cmdPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+      renderSemaphores[i].create(device);
+      renderFences[i].createSignaled(device);
+    }
+  }
+
+  void run() {
+    auto range = ezvk::defaultImageSubresourceRange(VK_IMAGE_ASPECT_COLOR_BIT);
+    for (u32 frame = 0; frame < FRAME_COUNT; ++frame) {
+      u32 slot = frame % 3;
+      vkWaitForFences(device, 1, &renderFences[slot], VK_TRUE,
+                      ezvk::TimelineSemaphore::NO_TIMEOUT);
+      renderFences[slot].reset(device);
+
+      u32         index;
+      VkSemaphore imageSemaphore;
+      auto        result = target.acquireNextImage(
+          device, ezvk::TimelineSemaphore::NO_TIMEOUT, &imageSemaphore,
+          &index);
+      if (result != VK_SUCCESS) {
+        puts("failed to acquire offscreen image");
+        exit(-1);
+      }
+
+      VkImageMemoryBarrier toClear{
+          .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+          .pNext               = nullptr,
+          .srcAccessMask       = VK_ACCESS_NONE,
+          .dstAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT,
+          .oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED,
+          .newLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+          .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+          .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+          .image               = target.m_images[index],
+          .subresourceRange    = range,
+      };
+      VkClearColorValue color{
+          .float32 = {float(frame * 16) / 255.f, 0.f, 1.f, 1.f},
+      };
+
+      auto& cmd = cmdBuffers[slot];
+      cmd.reset(0);
+      cmd.beginWithOneTimeSubmit();
+      cmd.pipelineImageBarrier(VK_PIPELINE_STAGE_TRANSFER_BIT,
+                               VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &toClear);
+      vkCmdClearColorImage(cmd.cmdBuffer, target.m_images[index],
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &color, 1,
+                           &range);
+      cmd.end();
+
+      VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+      VkSubmitInfo submitInfo{
+          .sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+          .pNext                = nullptr,
+          .waitSemaphoreCount   = imageSemaphore != VK_NULL_HANDLE ? 1u : 0u,
+          .pWaitSemaphores      = &imageSemaphore,
+          .pWaitDstStageMask    = &waitStage,
+          .commandBufferCount   = 1,
+          .pCommandBuffers      = &cmd.cmdBuffer,
+          .signalSemaphoreCount = 1,
+          .pSignalSemaphores    = &renderSemaphores[slot],
+      };
+      vkQueueSubmit(graphicsQueue, 1, &submitInfo, renderFences[slot]);
+      target.present(device, renderSemaphores[slot], index);
+      target.poll(device);
+    }
+    vkQueueWaitIdle(graphicsQueue);
+    target.poll(device);
+
+    printf("received %u of %u frames, %u mismatched\n", received, FRAME_COUNT,
+           mismatched);
+    if (received != FRAME_COUNT || mismatched != 0) {
+      exit(-1);
+    }
+  }
+
+  void destroy() {
+    for (u32 i = 0; i < 3; ++i) {
+      cmdBuffers[i].free(device, cmdPool);
+      renderSemaphores[i].destroy(device);
+      renderFences[i].destroy(device);
+    }
+    cmdPool.destroy(device);
+    target.destroy(device, allocator);
+    allocator.destroy();
+    device.destroy();
+    instance.destroy();
+  }
+};
+
+int main() {
+  App app;
+  app.init();
+  app.run();
+  app.destroy();
+}
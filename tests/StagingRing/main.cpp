@@ -0,0 +1,92 @@
+#include <EasyVK/TransferStream.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+
+void check(bool condition, const char* what) {
+  if (!condition) {
+    printf("failed: %s\n", what);
+    exit(-1);
+  }
+}
+
+void testWrapAround() {
+  ezvk::StagingRing ring;
+  ring.create(256, 16);
+
+  auto a = ring.allocate(100);
+  check(a && a->offset == 0 && a->charged == 100, "first allocation");
+  auto b = ring.allocate(50);
+  check(b && b->offset == 112 && b->charged == 62, "aligned allocation");
+
+  // 176 + 100 runs past the end: wraps to 0 and is charged for the tail,
+  // which does not fit while `a` is live
+  check(!ring.allocate(100), "wrap blocked by live allocation");
+  ring.release(a->charged);
+  auto c = ring.allocate(100);
+  check(c && c->offset == 0 && c->charged == 194, "wrapped allocation");
+  check(ring.used() == 256 && ring.head() == 100, "ring full after wrap");
+
+  // `b` still holds [112, 162)
+  check(!ring.allocate(1), "full ring refuses");
+  ring.release(b->charged);
+  auto d = ring.allocate(1);
+  check(d && d->offset == 112 && d->charged == 13, "space of b reused");
+
+  ring.release(c->charged);
+  ring.release(d->charged);
+  check(ring.used() == 0, "everything released");
+  auto e = ring.allocate(256);
+  check(e && e->offset == 0 && e->charged == 256, "empty ring restarts at 0");
+}
+
+// Random FIFO traffic; live allocations must never overlap and the charged
+// bytes must account for every byte between them.
+void testNoOverlap() {
+  constexpr VkDeviceSize CAPACITY = 4096;
+  ezvk::StagingRing      ring;
+  ring.create(CAPACITY, 16);
+
+  struct Live {
+    VkDeviceSize offset, size, charged;
+  };
+  std::deque<Live> live;
+  u32              seed = 7;
+  u32              wraps = 0;
+  for (u32 i = 0; i < 100000; ++i) {
+    seed              = seed * 1664525 + 1013904223;
+    VkDeviceSize size = 1 + (seed >> 16) % 1500;
+    auto         allocation = ring.allocate(size);
+    if (!allocation) {
+      check(!live.empty(), "allocation refused by an empty ring");
+      ring.release(live.front().charged);
+      live.pop_front();
+      continue;
+    }
+    check(allocation->offset % 16 == 0, "offset aligned");
+    check(allocation->offset + size <= CAPACITY, "allocation in bounds");
+    if (!live.empty() && allocation->offset < live.back().offset) {
+      wraps++;
+    }
+    for (auto const& other : live) {
+      check(allocation->offset + size <= other.offset ||
+                other.offset + other.size <= allocation->offset,
+            "allocations overlap");
+    }
+    live.push_back({allocation->offset, size, allocation->charged});
+
+    VkDeviceSize charged = 0;
+    for (auto const& other : live) {
+      charged += other.charged;
+    }
+    check(charged == ring.used(), "used matches charged bytes");
+  }
+  check(wraps > 0, "ring wrapped");
+}
+
+int main() {
+  testWrapAround();
+  testNoOverlap();
+  puts("StagingRing: ok");
+}